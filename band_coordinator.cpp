@@ -0,0 +1,162 @@
+/* ----------------------------------------------------------
+**
+**
+**   Band rendering coordinator
+**
+**   Renders one test case across band_worker processes and
+**   writes the framebuffer as the model would. --spawn-local
+**   forks loopback workers, and --verify checks the result
+**   against an in-process render byte for byte.
+**
+**   usage: band_coordinator [--input file] [--case N] [--size WxH]
+**                           [--port P] [--band-rows R] [--straggler-ms T]
+**                           [--spawn-local N] [--local-fail-after K]
+**                           [--local-delay-ms D] [--output file.txt]
+**                           [--ppm file.ppm] [--verify]
+**
+**   Remote workers: band_worker <coordinator host>:<port>
+**
+**   Luke Rule
+**
+---------------------------------------------------------- */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include "mandelbrot_renderer.h"
+#include "batch_render.h"
+#include "band_render.h"
+
+struct local_workers {
+  int count = 0;
+  int fail_after = -1;      // the first local worker crashes after this many bands
+  int delay_ms = 0;         // the second local worker is this much slower per band
+  std::vector<pid_t> pids;
+};
+
+static void spawn_local_workers(int port, void* context) {
+  local_workers& local = *static_cast<local_workers*>(context);
+  printf("coordinator listening on port %d\n", port);
+  fflush(stdout);
+  for (int i = 0; i < local.count; i++) {
+    pid_t pid = fork();
+    if (pid == 0) {
+      bool connected = run_band_worker("127.0.0.1", port, 1, i == 0 ? local.fail_after : -1, i == 1 ? local.delay_ms : 0);
+      _exit(connected ? 0 : 1);
+    }
+    if (pid > 0) {
+      local.pids.push_back(pid);
+    }
+  }
+}
+
+int main(int argc, char** argv)
+{
+  std::string input_file = "/home/p74644lr/Questa/COMP32211/src/Phase_2/input_file.txt";
+  std::string output;
+  std::string ppm;
+  int case_index = 0;
+  int width = DEFAULT_XSIZE;
+  int height = DEFAULT_YSIZE;
+  bool verify = false;
+  band_options options;
+  local_workers local;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--input") == 0 && i + 1 < argc) {
+      input_file = argv[++i];
+    }
+    else if (strcmp(argv[i], "--case") == 0 && i + 1 < argc) {
+      case_index = atoi(argv[++i]);
+    }
+    else if (strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+      if (sscanf(argv[++i], "%dx%d", &width, &height) != 2 || width < 1 || height < 1 || width > BAND_MAX_WIDTH || height > BAND_MAX_HEIGHT) {
+        fprintf(stderr, "bad size %s, expected WxH up to %dx%d\n", argv[i], BAND_MAX_WIDTH, BAND_MAX_HEIGHT);
+        return 1;
+      }
+    }
+    else if (strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
+      options.port = atoi(argv[++i]);
+    }
+    else if (strcmp(argv[i], "--band-rows") == 0 && i + 1 < argc) {
+      options.band_rows = std::max(1, atoi(argv[++i]));
+    }
+    else if (strcmp(argv[i], "--straggler-ms") == 0 && i + 1 < argc) {
+      options.straggler_ms = std::max(0, atoi(argv[++i]));
+    }
+    else if (strcmp(argv[i], "--spawn-local") == 0 && i + 1 < argc) {
+      local.count = std::max(0, atoi(argv[++i]));
+    }
+    else if (strcmp(argv[i], "--local-fail-after") == 0 && i + 1 < argc) {
+      local.fail_after = atoi(argv[++i]);
+    }
+    else if (strcmp(argv[i], "--local-delay-ms") == 0 && i + 1 < argc) {
+      local.delay_ms = std::max(0, atoi(argv[++i]));
+    }
+    else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+      output = argv[++i];
+    }
+    else if (strcmp(argv[i], "--ppm") == 0 && i + 1 < argc) {
+      ppm = argv[++i];
+    }
+    else if (strcmp(argv[i], "--verify") == 0) {
+      verify = true;
+    }
+  }
+
+  std::vector<test_case> cases = read_test_cases(input_file);
+  const test_case* found = find_test_case(cases, case_index);
+  if (found == nullptr) {
+    fprintf(stderr, "case %d is not in %s\n", case_index, input_file.c_str());
+    return 1;
+  }
+  const test_case& t = *found;
+  coord_step c = center_coords(t.center_x, t.center_y, t.zoom, width, height);
+
+  signal(SIGPIPE, SIG_IGN);
+  if (local.count > 0) {
+    options.on_listening = spawn_local_workers;
+    options.on_listening_context = &local;
+  }
+  std::vector<uint16_t> iterations(size_t(width) * height);
+  band_stats stats;
+  bool ok = render_bands(c, t.max_iterations, width, height, iterations.data(), options, stats);
+  for (pid_t pid : local.pids) {
+    waitpid(pid, nullptr, 0);
+  }
+  if (!ok) {
+    fprintf(stderr, "render failed: could not listen on port %d, or no workers\n", options.port);
+    return 1;
+  }
+  printf("%dx%d in %d bands on %d workers: %.3f s, %d failed, %d bands requeued, %d duplicated, %d late replies\n",
+         width, height, stats.bands, stats.workers, stats.seconds, stats.failed_workers, stats.requeued, stats.duplicated, stats.late_replies);
+
+  // colour here rather than in the workers, the colour map is cheap and stays in one place
+  std::vector<colour> unique_colours;
+  std::vector<colour> interp_points(t.colours, t.colours + 6);
+  std::vector<colour> colour_map;
+  generate_unique_colours(unique_colours, interp_points);
+  generate_colour_map(t.max_iterations, unique_colours, colour_map);
+  std::vector<colour> framebuffer(size_t(width) * height);
+  colouriseMandelbrot(iterations.data(), width, framebuffer.data(), width, width, height, t.max_iterations, colour_map);
+
+  if (!output.empty()) {
+    write_framebuffer_file(output, framebuffer.data(), width, height, width);
+  }
+  if (!ppm.empty()) {
+    write_ppm_file(ppm, framebuffer.data(), width, height, width);
+  }
+  if (verify) {
+    std::vector<colour> reference(size_t(width) * height);
+    drawMandelbrot(c.x, c.y, c.step, t.max_iterations, reference.data(), width, height, width, colour_map);
+    bool same = reference == framebuffer;
+    printf("verify: %s\n", same ? "byte-identical to the single-process render" : "DIFFERS from the single-process render");
+    return same ? 0 : 1;
+  }
+  return 0;
+}
@@ -0,0 +1,291 @@
+/* ----------------------------------------------------------
+**
+**
+**   Multi-process band rendering over TCP
+**
+**   Luke Rule
+**
+---------------------------------------------------------- */
+#include "band_render.h"
+
+#include <string.h>
+#include <unistd.h>
+#include <poll.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+
+#include "mandelbrot_renderer.h"
+
+// a reply has this long to arrive in full once it has started, or the worker counts as failed
+#define BAND_RECEIVE_TIMEOUT_S 5
+
+static bool write_all(int fd, const void* data, size_t bytes) {
+  const char* p = static_cast<const char*>(data);
+  while (bytes > 0) {
+    ssize_t written = write(fd, p, bytes);
+    if (written <= 0) {
+      return false;
+    }
+    p += written;
+    bytes -= written;
+  }
+  return true;
+}
+
+static bool read_all(int fd, void* data, size_t bytes) {
+  char* p = static_cast<char*>(data);
+  while (bytes > 0) {
+    ssize_t received = read(fd, p, bytes);
+    if (received <= 0) {
+      return false;
+    }
+    p += received;
+    bytes -= received;
+  }
+  return true;
+}
+
+static int64_t now_ms() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+enum band_state { BAND_PENDING, BAND_ASSIGNED, BAND_DONE };
+
+struct band_entry {
+  int first_row;
+  int rows;
+  band_state state = BAND_PENDING;
+  int assignees = 0;
+  int64_t assigned_ms = 0;
+};
+
+struct worker_connection {
+  int fd;
+  int band = -1;      // band being worked on, -1 when idle
+};
+
+// next band for an idle worker: a pending one, or else a copy of the longest outstanding straggler
+static int choose_band(std::vector<band_entry>& bands, int straggler_ms, band_stats& stats) {
+  for (size_t b = 0; b < bands.size(); b++) {
+    if (bands[b].state == BAND_PENDING) {
+      return b;
+    }
+  }
+  int oldest = -1;
+  int64_t now = now_ms();
+  for (size_t b = 0; b < bands.size(); b++) {
+    if (bands[b].state == BAND_ASSIGNED && bands[b].assignees < 2 && now - bands[b].assigned_ms >= straggler_ms &&
+        (oldest < 0 || bands[b].assigned_ms < bands[oldest].assigned_ms)) {
+      oldest = b;
+    }
+  }
+  if (oldest >= 0) {
+    stats.duplicated++;
+  }
+  return oldest;
+}
+
+// a worker went away: give its band back if nobody else is on it
+static void drop_worker(std::vector<worker_connection>& workers, size_t w, std::vector<band_entry>& bands, band_stats& stats) {
+  int b = workers[w].band;
+  if (b >= 0 && bands[b].state == BAND_ASSIGNED) {
+    stats.failed_workers++;
+    if (--bands[b].assignees == 0) {
+      bands[b].state = BAND_PENDING;
+      stats.requeued++;
+    }
+  }
+  close(workers[w].fd);
+  workers.erase(workers.begin() + w);
+}
+
+bool render_bands(const coord_step& c, int max_iterations, int width, int height, uint16_t* iterations, const band_options& options, band_stats& stats) {
+  auto start = std::chrono::steady_clock::now();
+  stats = band_stats();
+  int listener = socket(AF_INET, SOCK_STREAM, 0);
+  int one = 1;
+  setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+  struct sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_ANY);
+  address.sin_port = htons(options.port);
+  socklen_t length = sizeof(address);
+  if (listener < 0 || bind(listener, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) != 0 || listen(listener, 64) != 0 ||
+      getsockname(listener, reinterpret_cast<struct sockaddr*>(&address), &length) != 0) {
+    if (listener >= 0) {
+      close(listener);
+    }
+    return false;
+  }
+  if (options.on_listening != nullptr) {
+    options.on_listening(ntohs(address.sin_port), options.on_listening_context);
+  }
+
+  std::vector<band_entry> bands;
+  int band_rows = std::max(1, options.band_rows);
+  for (int y = 0; y < height; y += band_rows) {
+    band_entry b;
+    b.first_row = y;
+    b.rows = std::min(band_rows, height - y);
+    bands.push_back(b);
+  }
+  stats.bands = bands.size();
+  size_t done = 0;
+  std::vector<worker_connection> workers;
+  int64_t last_worker_ms = now_ms();
+  bool ok = true;
+
+  while (done < bands.size()) {
+    // hand out work to idle workers
+    for (size_t w = 0; w < workers.size();) {
+      if (workers[w].band >= 0) {
+        w++;
+        continue;
+      }
+      int b = choose_band(bands, options.straggler_ms, stats);
+      if (b < 0) {
+        w++;
+        continue;
+      }
+      band_request request = {BAND_MAGIC, uint32_t(b), c.x, c.y, c.step, max_iterations, width, bands[b].first_row, bands[b].rows};
+      if (!write_all(workers[w].fd, &request, sizeof(request))) {
+        drop_worker(workers, w, bands, stats);
+        continue;
+      }
+      workers[w].band = b;
+      if (bands[b].state == BAND_PENDING) {
+        bands[b].assigned_ms = now_ms();
+      }
+      bands[b].state = BAND_ASSIGNED;
+      bands[b].assignees++;
+      w++;
+    }
+
+    std::vector<struct pollfd> waiting;
+    waiting.push_back({listener, POLLIN, 0});
+    for (const worker_connection& worker : workers) {
+      waiting.push_back({worker.fd, POLLIN, 0});
+    }
+    // wake up now and then to look for stragglers
+    poll(waiting.data(), waiting.size(), std::max(10, options.straggler_ms / 4));
+
+    if (waiting[0].revents & POLLIN) {
+      int fd = accept(listener, nullptr, nullptr);
+      if (fd >= 0) {
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        struct timeval timeout = {BAND_RECEIVE_TIMEOUT_S, 0};
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        workers.push_back({fd, -1});
+        stats.workers++;
+      }
+    }
+    // walk backwards so dropping a worker does not disturb the indices still to visit
+    for (size_t i = waiting.size() - 1; i >= 1; i--) {
+      if (!(waiting[i].revents & (POLLIN | POLLHUP | POLLERR))) {
+        continue;
+      }
+      size_t w = i - 1;
+      int b = workers[w].band;
+      band_reply reply;
+      if (b < 0 || !read_all(workers[w].fd, &reply, sizeof(reply)) || reply.magic != BAND_MAGIC || reply.band != uint32_t(b) ||
+          reply.first_row != bands[b].first_row || reply.rows != bands[b].rows || reply.width != width) {
+        drop_worker(workers, w, bands, stats);
+        continue;
+      }
+      if (bands[b].state == BAND_DONE) {
+        // lost the race with another copy, read and discard
+        std::vector<uint16_t> discard(size_t(reply.rows) * width);
+        stats.late_replies++;
+        if (!read_all(workers[w].fd, discard.data(), discard.size() * sizeof(uint16_t))) {
+          drop_worker(workers, w, bands, stats);
+          continue;
+        }
+      }
+      else {
+        // workers fill disjoint bands, so the payload can go straight into the frame
+        if (!read_all(workers[w].fd, iterations + size_t(reply.first_row) * width, size_t(reply.rows) * width * sizeof(uint16_t))) {
+          drop_worker(workers, w, bands, stats);
+          continue;
+        }
+        bands[b].state = BAND_DONE;
+        done++;
+      }
+      bands[b].assignees--;
+      workers[w].band = -1;
+    }
+
+    if (!workers.empty()) {
+      last_worker_ms = now_ms();
+    }
+    else if (now_ms() - last_worker_ms > options.idle_timeout_ms) {
+      ok = false;
+      break;
+    }
+  }
+
+  band_request stop = {BAND_MAGIC, 0, 0, 0, 0, 0, 0, 0, 0};
+  for (const worker_connection& worker : workers) {
+    write_all(worker.fd, &stop, sizeof(stop));
+    close(worker.fd);
+  }
+  close(listener);
+  stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  return ok;
+}
+
+bool run_band_worker(const std::string& host, int port, int threads, int fail_after, int delay_ms) {
+  struct addrinfo hints = {};
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  struct addrinfo* addresses = nullptr;
+  if (getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &addresses) != 0) {
+    return false;
+  }
+  int fd = -1;
+  for (struct addrinfo* a = addresses; a != nullptr && fd < 0; a = a->ai_next) {
+    fd = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+    if (fd >= 0 && connect(fd, a->ai_addr, a->ai_addrlen) != 0) {
+      close(fd);
+      fd = -1;
+    }
+  }
+  freeaddrinfo(addresses);
+  if (fd < 0) {
+    return false;
+  }
+  int one = 1;
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+  std::vector<uint16_t> band;
+  int served = 0;
+  band_request request;
+  while (read_all(fd, &request, sizeof(request)) && request.magic == BAND_MAGIC && request.rows > 0) {
+    if (request.width < 1 || request.width > BAND_MAX_WIDTH || request.rows > BAND_MAX_HEIGHT) {
+      break;
+    }
+    if (fail_after >= 0 && served >= fail_after) {
+      // simulated crash: vanish holding a band
+      break;
+    }
+    band.resize(size_t(request.rows) * request.width);
+    fixed_32 y_first = step_coord(request.y, request.step, -request.first_row);
+    iterateMandelbrotParallel(request.x, y_first, request.step, request.max_iterations, band.data(), request.width, request.rows, request.width, threads);
+    if (delay_ms > 0) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(delay_ms));
+    }
+    band_reply reply = {BAND_MAGIC, request.band, request.first_row, request.rows, request.width};
+    if (!write_all(fd, &reply, sizeof(reply)) || !write_all(fd, band.data(), band.size() * sizeof(uint16_t))) {
+      break;
+    }
+    served++;
+  }
+  close(fd);
+  return true;
+}
@@ -0,0 +1,87 @@
+/* ----------------------------------------------------------
+**
+**
+**   Multi-process band rendering over TCP
+**
+**   A coordinator splits a frame into bands of rows and hands
+**   them to worker processes, local or on other hosts. Workers
+**   return iteration counts; the coordinator assembles them and
+**   colours the frame itself, so the result is byte-identical
+**   to a single-process render.
+**
+**   Bands of a failed worker go back in the queue, and once the
+**   queue is empty idle workers also take a second copy of any
+**   band that has been out for longer than straggler_ms. The
+**   first reply for a band wins.
+**
+**   Messages are the structs below in host byte order, so all
+**   hosts must be little-endian (x86 and ARM Linux both are).
+**
+**   Luke Rule
+**
+---------------------------------------------------------- */
+#ifndef BAND_RENDER_H
+#define BAND_RENDER_H
+
+#include <stdint.h>
+#include <string>
+
+#include "mandelbrot_fixed.h"
+
+#define BAND_DEFAULT_PORT 7878
+#define BAND_MAGIC 0x31444e42   // "BND1"
+// larger than a Renderer allows, e.g. for 8K stills
+#define BAND_MAX_WIDTH 16384
+#define BAND_MAX_HEIGHT 16384
+
+// coordinator to worker: iterate rows first_row to first_row + rows - 1; rows == 0 means stop
+struct band_request {
+  uint32_t magic;
+  uint32_t band;
+  int32_t x;
+  int32_t y;
+  int32_t step;
+  int32_t max_iterations;
+  int32_t width;
+  int32_t first_row;
+  int32_t rows;
+};
+
+// worker to coordinator, followed by rows * width uint16_t iteration counts
+struct band_reply {
+  uint32_t magic;
+  uint32_t band;
+  int32_t first_row;
+  int32_t rows;
+  int32_t width;
+};
+
+struct band_options {
+  int port = BAND_DEFAULT_PORT;   // 0 picks a free port, see listening_port
+  int band_rows = 32;
+  int straggler_ms = 250;
+  int idle_timeout_ms = 10000;    // give up when no worker has been connected for this long
+  // called once the coordinator is listening, e.g. to start local workers on the chosen port
+  void (*on_listening)(int port, void* context) = nullptr;
+  void* on_listening_context = nullptr;
+};
+
+struct band_stats {
+  int bands = 0;
+  int workers = 0;                // connections accepted
+  int failed_workers = 0;         // connections lost with a band outstanding
+  int requeued = 0;               // bands put back after a failure
+  int duplicated = 0;             // straggler bands handed to a second worker
+  int late_replies = 0;           // replies for bands already filled by another worker
+  double seconds = 0.0;
+};
+
+// Coordinator: fill iterations (width * height, row-major) from connected workers. Returns false
+// if the port cannot be opened or the workers all disappear for idle_timeout_ms.
+bool render_bands(const coord_step& c, int max_iterations, int width, int height, uint16_t* iterations, const band_options& options, band_stats& stats);
+
+// Worker: connect and serve bands until the coordinator says stop or goes away; false if the
+// connection could not be made. fail_after and delay_ms simulate failing and slow workers.
+bool run_band_worker(const std::string& host, int port, int threads = 1, int fail_after = -1, int delay_ms = 0);
+
+#endif
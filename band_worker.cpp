@@ -0,0 +1,65 @@
+/* ----------------------------------------------------------
+**
+**
+**   Band rendering worker
+**
+**   Connects to a band_coordinator and iterates the bands it is
+**   sent until the frame is finished.
+**
+**   usage: band_worker <host>[:port] [--threads N]
+**                      [--fail-after K] [--delay-ms D]
+**
+**   --fail-after and --delay-ms make a crashing or slow worker
+**   for testing the coordinator's reassignment.
+**
+**   Luke Rule
+**
+---------------------------------------------------------- */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <string>
+#include <thread>
+#include <algorithm>
+
+#include "band_render.h"
+
+int main(int argc, char** argv)
+{
+  if (argc < 2) {
+    fprintf(stderr, "usage: band_worker <host>[:port] [--threads N] [--fail-after K] [--delay-ms D]\n");
+    return 1;
+  }
+  std::string host = argv[1];
+  int port = BAND_DEFAULT_PORT;
+  size_t colon = host.rfind(':');
+  if (colon != std::string::npos) {
+    port = atoi(host.c_str() + colon + 1);
+    host = host.substr(0, colon);
+  }
+  int threads = 1;
+  int fail_after = -1;
+  int delay_ms = 0;
+  for (int i = 2; i < argc; i++) {
+    if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+      threads = atoi(argv[++i]);
+      if (threads <= 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+      }
+    }
+    else if (strcmp(argv[i], "--fail-after") == 0 && i + 1 < argc) {
+      fail_after = atoi(argv[++i]);
+    }
+    else if (strcmp(argv[i], "--delay-ms") == 0 && i + 1 < argc) {
+      delay_ms = std::max(0, atoi(argv[++i]));
+    }
+  }
+
+  signal(SIGPIPE, SIG_IGN);
+  if (!run_band_worker(host, port, threads, fail_after, delay_ms)) {
+    fprintf(stderr, "could not connect to %s:%d\n", host.c_str(), port);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,121 @@
+/* ----------------------------------------------------------
+**
+**
+**   Batch scheduling check
+**
+**   Runs run_batch on an input file for every --jobs from 1 to
+**   N and every --max-inflight from 1 to jobs + 1, and checks
+**   each run finishes within the timeout and writes the same
+**   output files as jobs 1. Frames are small by default, since
+**   the point is the hand-back between workers, not the pixels.
+**
+**   usage: batch_check [--input file] [--jobs N] [--size WxH]
+**                      [--timeout S] [--dir path/]
+**
+**   Exits with status 1 if a run hangs or its output differs.
+**
+**   Luke Rule
+**
+---------------------------------------------------------- */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <future>
+
+#include "mandelbrot_renderer.h"
+#include "batch_render.h"
+
+static std::string read_file(const std::string& filename) {
+  std::ifstream file(filename);
+  std::ostringstream contents;
+  contents << file.rdbuf();
+  return contents.str();
+}
+
+int main(int argc, char** argv)
+{
+  std::string input_file = "/home/p74644lr/Questa/COMP32211/src/Phase_2/input_file.txt";
+  std::string dir = "batch_check/";
+  int max_jobs = 4;
+  int width = 80;
+  int height = 60;
+  int timeout = 60;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--input") == 0 && i + 1 < argc) {
+      input_file = argv[++i];
+    }
+    else if (strcmp(argv[i], "--jobs") == 0 && i + 1 < argc) {
+      max_jobs = std::max(1, atoi(argv[++i]));
+    }
+    else if (strcmp(argv[i], "--timeout") == 0 && i + 1 < argc) {
+      timeout = std::max(1, atoi(argv[++i]));
+    }
+    else if (strcmp(argv[i], "--dir") == 0 && i + 1 < argc) {
+      dir = argv[++i];
+      if (dir.empty() || dir.back() != '/') {
+        dir += "/";
+      }
+    }
+    else if (strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+      if (sscanf(argv[++i], "%dx%d", &width, &height) != 2 || width < 1 || height < 1 || width > MAX_XSIZE || height > MAX_YSIZE) {
+        fprintf(stderr, "bad size\n");
+        return 1;
+      }
+    }
+  }
+
+  std::vector<test_case> cases = read_test_cases(input_file);
+  if (cases.empty()) {
+    fprintf(stderr, "no cases in %s\n", input_file.c_str());
+    return 1;
+  }
+  mkdir(dir.c_str(), 0755);
+  std::vector<geometry_group> groups = plan_geometry_groups(cases, false, width, height);
+  std::vector<std::string> expected;
+  bool failed = false;
+
+  printf("%zu cases at %dx%d\n", cases.size(), width, height);
+  for (int jobs = 1; jobs <= max_jobs; jobs++) {
+    for (int inflight = 1; inflight <= jobs + 1; inflight++) {
+      batch_options options;
+      options.jobs = jobs;
+      options.max_inflight = inflight;
+      options.width = width;
+      options.height = height;
+      options.output_dir = dir;
+      auto start = std::chrono::steady_clock::now();
+      // a hung batch cannot be joined, so it is waited on with a timeout and abandoned
+      std::future<void> done = std::async(std::launch::async, [&] { run_batch(cases, groups, options); });
+      if (done.wait_for(std::chrono::seconds(timeout)) != std::future_status::ready) {
+        printf("jobs %d, max-inflight %d: still running after %d s\n", jobs, inflight, timeout);
+        fflush(stdout);
+        _exit(1);
+      }
+      double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+      int differ = 0;
+      for (size_t i = 0; i < cases.size(); i++) {
+        std::string output = read_file(dir + "output_file_" + std::to_string(cases[i].file_count) + ".txt");
+        if (expected.size() < cases.size()) {
+          expected.push_back(output);
+        }
+        else if (output != expected[i]) {
+          differ++;
+        }
+      }
+      printf("jobs %d, max-inflight %d: %.1f ms%s\n", jobs, inflight, ms, differ != 0 ? "  MISMATCH" : "");
+      if (differ != 0) {
+        printf("  %d of %zu output files differ from jobs 1\n", differ, cases.size());
+        failed = true;
+      }
+    }
+  }
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,241 @@
+/* ----------------------------------------------------------
+**
+**
+**   Batch rendering of input_file.txt test cases
+**
+**   Luke Rule
+**
+---------------------------------------------------------- */
+#include "batch_render.h"
+
+#include <stdio.h>
+#include <fstream>
+#include <sstream>
+#include <map>
+#include <tuple>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
+
+static int trap_max_iterations(int max_iterations) {
+  if (max_iterations <= 0) {
+    return 1;
+  }
+  if (max_iterations > MAX_ITERATIONS) {
+    return 1; // as unsigned in verilog
+  }
+  return max_iterations;
+}
+
+// parse a test case line, trapping max iterations as the RTL does
+bool parse_test_case(const std::string& line, test_case& t) {
+  std::istringstream iss(line);
+  iss >> std::hex >> t.center_x >> t.center_y >> std::dec >> t.zoom >> t.max_iterations;
+  iss >> std::hex;
+  for (int i = 0; i < 6; i++) {
+    iss >> t.colours[i];
+  }
+  iss >> std::dec >> t.ack_mode;
+  // all 11 fields, or the missing ones would be taken as zero
+  if (iss.fail()) {
+    return false;
+  }
+  t.requested_max_iterations = t.max_iterations;
+  t.max_iterations = trap_max_iterations(t.max_iterations);
+  return true;
+}
+
+std::vector<test_case> read_test_cases(const std::string& filename) {
+  std::vector<test_case> cases;
+  std::ifstream input(filename, std::ios::binary);
+  uint32_t magic = 0;
+  if (input.read(reinterpret_cast<char*>(&magic), sizeof(magic)) && magic == BATCH_FILE_MAGIC) {
+    batch_record r;
+    while (input.read(reinterpret_cast<char*>(&r), sizeof(r))) {
+      test_case t = {};
+      // held as the text parse holds them, not sign-extended
+      t.center_x = r.center_x;
+      t.center_y = r.center_y;
+      t.zoom = r.zoom;
+      t.requested_max_iterations = r.max_iterations;
+      t.max_iterations = trap_max_iterations(r.max_iterations);
+      std::copy(r.colours, r.colours + 6, t.colours);
+      t.ack_mode = r.ack_mode;
+      t.file_count = cases.size();
+      cases.push_back(t);
+    }
+    return cases;
+  }
+  input.clear();
+  input.seekg(0);
+  // numbered by line, as the testbench's test_counter names its output files, whatever is skipped
+  std::string line;
+  for (int line_number = 0; std::getline(input, line); line_number++) {
+    test_case t = {};
+    if (line.find_first_not_of(" \t\r") == std::string::npos) {
+      continue;
+    }
+    if (!parse_test_case(line, t)) {
+      fprintf(stderr, "%s:%d: not a test case, skipped\n", filename.c_str(), line_number + 1);
+      continue;
+    }
+    t.file_count = line_number;
+    cases.push_back(t);
+  }
+  return cases;
+}
+
+const test_case* find_test_case(const std::vector<test_case>& cases, int file_count) {
+  for (const test_case& t : cases) {
+    if (t.file_count == file_count) {
+      return &t;
+    }
+  }
+  return nullptr;
+}
+
+std::vector<geometry_group> plan_geometry_groups(const std::vector<test_case>& cases, bool dedup, int width, int height) {
+  std::vector<geometry_group> groups;
+  std::map<std::tuple<fixed_32, fixed_32, fixed_32, int>, size_t> lookup;
+  for (size_t i = 0; i < cases.size(); i++) {
+    const test_case& t = cases[i];
+    coord_step c = center_coords(t.center_x, t.center_y, t.zoom, width, height);
+    std::tuple<fixed_32, fixed_32, fixed_32, int> key(c.x, c.y, c.step, t.max_iterations);
+    auto found = lookup.find(key);
+    if (dedup && found != lookup.end()) {
+      groups[found->second].cases.push_back(i);
+      continue;
+    }
+    lookup[key] = groups.size();
+    groups.push_back({c, t.max_iterations, {int(i)}});
+  }
+  return groups;
+}
+
+// colour a case from its group's iteration counts and write its golden output files
+static void render_test_case(const test_case& t, Renderer& renderer, const batch_options& options) {
+  // generate colour map
+  renderer.build_colour_map(t.colours, t.max_iterations);
+  // initialize framebuffer to grey to better see uninitialized pixels
+  renderer.clear(0x7BEF);
+  renderer.colourise();
+
+  // write output files
+  std::string image = options.image_dir + std::to_string(t.file_count) + std::string("_framestore_golden.ppm");
+  write_ppm_file(image, renderer.framebuffer(), renderer.width(), renderer.height(), renderer.stride());
+  std::string values = options.output_dir + std::string("output_file_") + std::to_string(t.file_count) + std::string(".txt");
+  write_framebuffer_file(values, renderer.framebuffer(), renderer.width(), renderer.height(), renderer.stride());
+}
+
+// colour straight into the next ring slot rather than copying a finished framebuffer
+static void publish_test_case(framebuffer_ring& ring, const test_case& t, Renderer& renderer) {
+  renderer.build_colour_map(t.colours, t.max_iterations);
+  renderer.colourise(ring_begin_publish(ring), renderer.width());
+
+  ring_frame_meta meta = {};
+  meta.center_x = t.center_x;
+  meta.center_y = t.center_y;
+  meta.zoom = t.zoom;
+  meta.max_iterations = t.max_iterations;
+  for (int i = 0; i < 6; i++) {
+    meta.colours[i] = t.colours[i];
+  }
+  meta.file_count = t.file_count;
+  meta.width = renderer.width();
+  meta.height = renderer.height();
+  ring_end_publish(ring, meta);
+}
+
+// Render all groups on a pool of jobs workers, each using frame_threads threads per frame.
+// Workers take a Renderer from a fixed pool before claiming the next group, so memory
+// is bounded by max_inflight renderers. Finished groups are handed back in order, which keeps ring
+// publishing deterministic whatever order the workers complete in. Taking the renderer before
+// the group guarantees the oldest unfinished group always has one, so the ordered hand-back
+// can never deadlock.
+void run_batch(const std::vector<test_case>& cases, const std::vector<geometry_group>& groups, const batch_options& options) {
+  int jobs = std::max(1, options.jobs);
+  int inflight = options.max_inflight > 0 ? options.max_inflight : jobs + 1;
+
+  std::vector<std::unique_ptr<Renderer>> storage;
+  std::vector<Renderer*> free_renderers;
+  for (int i = 0; i < inflight; i++) {
+    storage.emplace_back(new Renderer(options.width, options.height));
+    storage.back()->set_layout(options.layout);
+    storage.back()->set_mirror(options.mirror);
+    free_renderers.push_back(storage.back().get());
+  }
+  std::vector<Renderer*> finished(groups.size(), nullptr);
+  FRAME_STATS(std::vector<std::string> stats_lines(cases.size());)
+  std::mutex mutex;
+  std::condition_variable renderer_freed;
+  std::condition_variable group_finished;
+  size_t next_group = 0;
+
+  auto worker = [&]() {
+    while (true) {
+      Renderer* renderer;
+      size_t index;
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        renderer_freed.wait(lock, [&] { return !free_renderers.empty() || next_group >= groups.size(); });
+        if (next_group >= groups.size()) {
+          return;
+        }
+        renderer = free_renderers.back();
+        free_renderers.pop_back();
+        index = next_group++;
+      }
+      // workers still waiting for a renderer would otherwise only wake on a hand-back
+      if (index + 1 == groups.size()) {
+        renderer_freed.notify_all();
+      }
+      const geometry_group& g = groups[index];
+      renderer->iterate(g.c, g.max_iterations, options.frame_threads);
+      for (int case_index : g.cases) {
+        render_test_case(cases[case_index], *renderer, options);
+        FRAME_STATS(stats_lines[case_index] = frame_stats_json(renderer->stats(), cases[case_index].file_count);)
+      }
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        finished[index] = renderer;
+      }
+      group_finished.notify_all();
+    }
+  };
+
+  std::vector<std::thread> workers;
+  for (int j = 0; j < jobs; j++) {
+    workers.emplace_back(worker);
+  }
+  // hand groups back in order on this thread
+  for (size_t i = 0; i < groups.size(); i++) {
+    Renderer* renderer;
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      group_finished.wait(lock, [&] { return finished[i] != nullptr; });
+      renderer = finished[i];
+    }
+    if (options.ring != nullptr) {
+      for (int case_index : groups[i].cases) {
+        publish_test_case(*options.ring, cases[case_index], *renderer);
+      }
+    }
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      free_renderers.push_back(renderer);
+    }
+    renderer_freed.notify_one();
+  }
+  for (std::thread& w : workers) {
+    w.join();
+  }
+#ifdef MANDELBROT_STATS
+  // one line per case in input order, next to the output files
+  std::ofstream stats_file(options.output_dir + "frame_stats.jsonl");
+  for (const std::string& line : stats_lines) {
+    stats_file << line << "\n";
+  }
+#endif
+}
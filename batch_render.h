@@ -0,0 +1,81 @@
+/* ----------------------------------------------------------
+**
+**
+**   Batch rendering of input_file.txt test cases
+**
+**   Luke Rule
+**
+---------------------------------------------------------- */
+#ifndef BATCH_RENDER_H
+#define BATCH_RENDER_H
+
+#include <string>
+#include <vector>
+
+#include "mandelbrot_renderer.h"
+#include "framebuffer_ring.h"
+
+// one line of input_file.txt
+struct test_case {
+  fixed_64 center_x;
+  fixed_64 center_y;
+  int zoom;
+  int max_iterations;
+  colour colours[6];
+  int file_count;
+  int requested_max_iterations;   // as written, before trapping
+  int ack_mode;                   // the line's last field: 0 for instant ack
+};
+
+// Binary batch files, for suites too large to want parsing: BATCH_FILE_MAGIC, then one record
+// per case to the end of the file, in host byte order (little-endian on x86 and ARM Linux)
+#define BATCH_FILE_MAGIC 0x31484342   // "BCH1"
+
+struct batch_record {
+  uint32_t center_x;
+  uint32_t center_y;
+  int32_t zoom;
+  int32_t max_iterations;     // as in the text line, trapped when read
+  uint16_t colours[6];
+  int32_t ack_mode;           // the line's last field: 0 for instant ack
+};
+
+// cases sharing a view and iteration limit, iterated once and coloured per case
+struct geometry_group {
+  coord_step c;
+  int max_iterations;
+  std::vector<int> cases;     // indices into the case list, not file counts
+};
+
+struct batch_options {
+  int jobs = 1;               // whole cases rendered at once
+  int frame_threads = 1;      // threads inside each frame
+  int max_inflight = 0;       // renderers allocated at once, 0 picks jobs + 1
+  bool dedup = false;         // iterate each distinct geometry once
+  buffer_layout layout = LAYOUT_ROW_MAJOR;
+  bool mirror = false;        // conjugate-symmetry mirroring of row-major views, see iterateMandelbrotMirrored
+  int width = DEFAULT_XSIZE;
+  int height = DEFAULT_YSIZE;
+  std::string image_dir = "images/";
+  std::string output_dir = "output_files/";   // golden output files, relative to the working directory unless absolute
+  framebuffer_ring* ring = nullptr;
+};
+
+// parse a test case line, trapping max iterations as the RTL does
+bool parse_test_case(const std::string& line, test_case& t);
+// Reads input_file.txt lines or a binary batch file, told apart by the magic number. Blank lines
+// are skipped, and malformed ones reported on stderr and skipped. file_count is the line's number
+// from 0 either way, so output files keep the names the testbench expects.
+std::vector<test_case> read_test_cases(const std::string& filename);
+// the case with that file_count, or nullptr
+const test_case* find_test_case(const std::vector<test_case>& cases, int file_count);
+
+// Group cases by the view the hardware would actually draw: zoom is trapped by center_coords
+// and max_iterations was trapped when parsing, so e.g. zoom 15 and zoom 0 share a group. Colours
+// and the ack-mode field do not affect iteration counts. Groups are ordered by their first case.
+std::vector<geometry_group> plan_geometry_groups(const std::vector<test_case>& cases, bool dedup, int width = DEFAULT_XSIZE, int height = DEFAULT_YSIZE);
+
+// render every group and write the golden output files for each case
+void run_batch(const std::vector<test_case>& cases, const std::vector<geometry_group>& groups, const batch_options& options);
+
+#endif
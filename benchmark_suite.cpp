@@ -0,0 +1,245 @@
+/* ----------------------------------------------------------
+**
+**
+**   Benchmark suite of canonical views
+**
+**   Renders the named views of test_input_generator.py at
+**   several iteration limits and reports Mpixel/s, Giteration/s
+**   and per-view latency percentiles. Results can be saved as
+**   a baseline and later runs gated against it.
+**
+**   usage: benchmark_suite [--reps R] [--threads N] [--size WxH]
+**                          [--iterations 64,180,511] [--view name]
+**                          [--json results.json]
+**                          [--baseline baseline.json] [--tolerance 0.10]
+**
+**   Exit status is 1 if any view is slower than the baseline by
+**   more than the tolerance or iterates a different total, which
+**   means the view itself changed.
+**
+**   Luke Rule
+**
+---------------------------------------------------------- */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <map>
+#include <chrono>
+#include <thread>
+#include <fstream>
+#include <algorithm>
+
+#include "mandelbrot_renderer.h"
+
+struct suite_view {
+  const char* name;
+  double x;
+  double y;
+  int zoom;
+};
+
+// the fixed windows of test_input_generator.py
+static const suite_view suite_views[] = {
+  {"full", -0.5, 0.0, 0},
+  {"cardioid_edge", -0.7467, 0.163, 6},
+  {"period2_valley", -0.749, 0.07, 5},
+  {"period2_3_valley", -1.26, -0.07, 5},
+  {"minibrot", -1.766, 0.0, 5},
+  {"outer_branches", -0.2, -0.865, 3},
+  {"very_zoomed", 0.001643721971153, -0.822467633298876, 8},
+  {"right_valley", 0.285, 0.0, 5},
+  {"seahorse", -0.745, 0.186, 6},
+  {"elephant", 0.273, 0.007, 7},
+  {"exterior", 2.0, 1.5, 0},
+  {"origin", 0.0, 0.0, 0},
+};
+
+struct suite_result {
+  std::string view;
+  int max_iterations;
+  double mpix_per_s;       // from the median latency
+  double giter_per_s;
+  double p50_ms;
+  double p90_ms;
+  double max_ms;
+  unsigned long long iterations;
+};
+
+static fixed_32 to_fixed(double value) {
+  return fixed_32(int64_t(value * (1 << FRAC_BITS)));
+}
+
+static void write_results(const std::string& filename, const std::vector<suite_result>& results, int width, int height, int threads) {
+  std::ofstream out(filename);
+  out << "{\"width\": " << width << ", \"height\": " << height << ", \"threads\": " << threads << ", \"results\": [\n";
+  for (size_t i = 0; i < results.size(); i++) {
+    const suite_result& r = results[i];
+    char line[320];
+    // one result per line, read_baseline relies on it
+    snprintf(line, sizeof(line),
+             "  {\"view\": \"%s\", \"max_iterations\": %d, \"mpix_per_s\": %.3f, \"giter_per_s\": %.4f, "
+             "\"p50_ms\": %.3f, \"p90_ms\": %.3f, \"max_ms\": %.3f, \"iterations\": %llu}%s\n",
+             r.view.c_str(), r.max_iterations, r.mpix_per_s, r.giter_per_s, r.p50_ms, r.p90_ms, r.max_ms,
+             r.iterations, i + 1 < results.size() ? "," : "");
+    out << line;
+  }
+  out << "]}\n";
+}
+
+// read a file written by write_results, keyed by view and max_iterations, with the size and
+// thread count it was measured at; false if it cannot be read or has no such header
+static bool read_baseline(const std::string& filename, std::map<std::pair<std::string, int>, suite_result>& baseline, int& width, int& height,
+                          int& threads) {
+  std::ifstream input(filename);
+  std::string line;
+  if (!std::getline(input, line) ||
+      sscanf(line.c_str(), "{\"width\": %d, \"height\": %d, \"threads\": %d,", &width, &height, &threads) != 3) {
+    return false;
+  }
+  while (std::getline(input, line)) {
+    char view[64];
+    suite_result r;
+    if (sscanf(line.c_str(), " {\"view\": \"%63[^\"]\", \"max_iterations\": %d, \"mpix_per_s\": %lf, \"giter_per_s\": %lf, "
+               "\"p50_ms\": %lf, \"p90_ms\": %lf, \"max_ms\": %lf, \"iterations\": %llu",
+               view, &r.max_iterations, &r.mpix_per_s, &r.giter_per_s, &r.p50_ms, &r.p90_ms, &r.max_ms, &r.iterations) == 8) {
+      r.view = view;
+      baseline[{r.view, r.max_iterations}] = r;
+    }
+  }
+  return true;
+}
+
+int main(int argc, char** argv)
+{
+  int reps = 7;
+  int threads = 1;
+  int width = DEFAULT_XSIZE;
+  int height = DEFAULT_YSIZE;
+  std::vector<int> limits = {64, 180, 511, 1023};
+  std::string only_view;
+  std::string json_file;
+  std::string baseline_file;
+  double tolerance = 0.10;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--reps") == 0 && i + 1 < argc) {
+      reps = std::max(1, atoi(argv[++i]));
+    }
+    else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+      threads = atoi(argv[++i]);
+      if (threads <= 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+      }
+    }
+    else if (strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+      if (sscanf(argv[++i], "%dx%d", &width, &height) != 2 || width < 1 || height < 1 || width > MAX_XSIZE || height > MAX_YSIZE) {
+        fprintf(stderr, "bad size\n");
+        return 1;
+      }
+    }
+    else if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+      limits.clear();
+      for (char* p = strtok(argv[++i], ","); p != nullptr; p = strtok(nullptr, ",")) {
+        int limit = atoi(p);
+        if (limit > 0 && limit <= MAX_ITERATIONS) {
+          limits.push_back(limit);
+        }
+      }
+    }
+    else if (strcmp(argv[i], "--view") == 0 && i + 1 < argc) {
+      only_view = argv[++i];
+    }
+    else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+      json_file = argv[++i];
+    }
+    else if (strcmp(argv[i], "--baseline") == 0 && i + 1 < argc) {
+      baseline_file = argv[++i];
+    }
+    else if (strcmp(argv[i], "--tolerance") == 0 && i + 1 < argc) {
+      tolerance = atof(argv[++i]);
+    }
+  }
+
+  std::map<std::pair<std::string, int>, suite_result> baseline;
+  if (!baseline_file.empty()) {
+    int baseline_width, baseline_height, baseline_threads;
+    if (!read_baseline(baseline_file, baseline, baseline_width, baseline_height, baseline_threads)) {
+      fprintf(stderr, "could not read baseline %s\n", baseline_file.c_str());
+      return 1;
+    }
+    // throughput at another size or thread count says nothing about a regression
+    if (baseline_width != width || baseline_height != height || baseline_threads != threads) {
+      fprintf(stderr, "baseline %s was measured at %dx%d on %d threads, this run is %dx%d on %d threads\n", baseline_file.c_str(), baseline_width,
+              baseline_height, baseline_threads, width, height, threads);
+      return 1;
+    }
+  }
+
+  Renderer renderer(width, height);
+  const colour palette[6] = {0x001f, 0x07ff, 0x07e0, 0xffe0, 0xf800, 0xf81f};
+  double mpixels = double(width) * height / 1e6;
+  std::vector<suite_result> results;
+  int regressions = 0;
+
+  printf("%dx%d, %d threads, %d reps, tolerance %.0f%%\n\n", width, height, threads, reps, tolerance * 100);
+  printf("%-18s %6s %10s %10s %9s %9s %9s %s\n", "view", "max", "Mpix/s", "Giter/s", "p50 ms", "p90 ms", "max ms", baseline.empty() ? "" : "vs baseline");
+  for (const suite_view& v : suite_views) {
+    if (!only_view.empty() && only_view != v.name) {
+      continue;
+    }
+    coord_step c = renderer.view(to_fixed(v.x), to_fixed(v.y), v.zoom);
+    for (int limit : limits) {
+      renderer.build_colour_map(palette, limit);
+      // one untimed render to warm caches and count the work
+      renderer.iterate(c, limit, threads);
+      unsigned long long iterations = 0;
+      for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+          iterations += renderer.iteration_at(x, y);
+        }
+      }
+
+      std::vector<double> latencies_ms;
+      for (int r = 0; r < reps; r++) {
+        auto start = std::chrono::steady_clock::now();
+        renderer.iterate(c, limit, threads);
+        renderer.colourise();
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        latencies_ms.push_back(elapsed.count());
+      }
+      std::sort(latencies_ms.begin(), latencies_ms.end());
+      suite_result result;
+      result.view = v.name;
+      result.max_iterations = limit;
+      result.p50_ms = latencies_ms[latencies_ms.size() / 2];
+      result.p90_ms = latencies_ms[std::min(latencies_ms.size() - 1, latencies_ms.size() * 9 / 10)];
+      result.max_ms = latencies_ms.back();
+      result.mpix_per_s = mpixels / (result.p50_ms / 1e3);
+      result.giter_per_s = iterations / 1e9 / (result.p50_ms / 1e3);
+      result.iterations = iterations;
+      results.push_back(result);
+
+      printf("%-18s %6d %10.2f %10.3f %9.3f %9.3f %9.3f", v.name, limit, result.mpix_per_s, result.giter_per_s,
+             result.p50_ms, result.p90_ms, result.max_ms);
+      auto found = baseline.find({result.view, limit});
+      if (found != baseline.end()) {
+        double change = result.mpix_per_s / found->second.mpix_per_s - 1.0;
+        bool changed_view = found->second.iterations != iterations;
+        bool slower = change < -tolerance;
+        printf(" %+6.1f%%%s", change * 100, changed_view ? "  VIEW CHANGED" : slower ? "  REGRESSION" : "");
+        regressions += changed_view || slower;
+      }
+      printf("\n");
+    }
+  }
+
+  if (!json_file.empty()) {
+    write_results(json_file, results, width, height, threads);
+  }
+  if (regressions > 0) {
+    printf("\n%d result%s outside tolerance of %s\n", regressions, regressions == 1 ? "" : "s", baseline_file.c_str());
+    return 1;
+  }
+  return 0;
+}
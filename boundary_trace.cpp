@@ -0,0 +1,130 @@
+/* ----------------------------------------------------------
+**
+**
+**   Boundary-tracing renderer
+**
+**   Luke Rule
+**
+---------------------------------------------------------- */
+#include "boundary_trace.h"
+
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+#define TRACE_LOADED 1
+#define TRACE_QUEUED 2
+
+// Trace rows first_row to last_row - 1. Every pixel taken off the stack is compared with its four
+// neighbours, iterating them if need be; where a neighbour's count differs, both sides of that
+// contour are queued, including the diagonals between two differing neighbours so a contour
+// cannot slip past a corner. Whatever was never iterated lies inside a contour and is filled
+// left to right, each row starting from an iterated edge pixel.
+static void trace_band(fixed_32 x_fixed, fixed_32 y_fixed, fixed_32 inc_fixed, int max_iterations, uint16_t* iteration_buffer, int width, int first_row, int last_row, size_t stride, trace_stats* stats) {
+  int height = last_row - first_row;
+  std::vector<uint8_t> state(size_t(width) * height, 0);
+  std::vector<uint32_t> stack;
+  uint16_t* band = iteration_buffer + first_row * stride;
+
+  auto load = [&](int x, int y) {
+    size_t i = size_t(y) * width + x;
+    if (!(state[i] & TRACE_LOADED)) {
+      band[y * stride + x] = iterate_point(step_coord(x_fixed, inc_fixed, x), step_coord(y_fixed, inc_fixed, -(first_row + y)), max_iterations);
+      state[i] |= TRACE_LOADED;
+      stats->iterated++;
+    }
+    return band[y * stride + x];
+  };
+  auto queue = [&](int x, int y) {
+    size_t i = size_t(y) * width + x;
+    if (!(state[i] & TRACE_QUEUED)) {
+      state[i] |= TRACE_QUEUED;
+      stack.push_back(uint32_t(i));
+    }
+  };
+
+  for (int x = 0; x < width; x++) {
+    queue(x, 0);
+    queue(x, height - 1);
+  }
+  for (int y = 1; y < height - 1; y++) {
+    queue(0, y);
+    queue(width - 1, y);
+  }
+  while (!stack.empty()) {
+    uint32_t i = stack.back();
+    stack.pop_back();
+    int x = i % width;
+    int y = i / width;
+    uint16_t centre = load(x, y);
+    bool has_left = x > 0;
+    bool has_right = x < width - 1;
+    bool has_up = y > 0;
+    bool has_down = y < height - 1;
+    bool left = has_left && load(x - 1, y) != centre;
+    bool right = has_right && load(x + 1, y) != centre;
+    bool up = has_up && load(x, y - 1) != centre;
+    bool down = has_down && load(x, y + 1) != centre;
+    if (left) {
+      queue(x - 1, y);
+    }
+    if (right) {
+      queue(x + 1, y);
+    }
+    if (up) {
+      queue(x, y - 1);
+    }
+    if (down) {
+      queue(x, y + 1);
+    }
+    if (has_up && has_left && (up || left)) {
+      queue(x - 1, y - 1);
+    }
+    if (has_up && has_right && (up || right)) {
+      queue(x + 1, y - 1);
+    }
+    if (has_down && has_left && (down || left)) {
+      queue(x - 1, y + 1);
+    }
+    if (has_down && has_right && (down || right)) {
+      queue(x + 1, y + 1);
+    }
+  }
+
+  for (int y = 0; y < height; y++) {
+    uint16_t* row = band + y * stride;
+    const uint8_t* row_state = state.data() + size_t(y) * width;
+    for (int x = 1; x < width; x++) {
+      if (!(row_state[x] & TRACE_LOADED)) {
+        row[x] = row[x - 1];
+        stats->filled++;
+      }
+    }
+  }
+}
+
+void iterateMandelbrotTraced(fixed_32 x_fixed, fixed_32 y_fixed, fixed_32 inc_fixed, int max_iterations, uint16_t* iteration_buffer, int width, int height, size_t stride, int threads, trace_stats* stats) {
+  int bands = std::max(1, std::min(threads, height));
+  std::vector<trace_stats> band_stats(bands);
+  std::vector<std::thread> workers;
+  for (int b = 0; b < bands; b++) {
+    int first_row = int(int64_t(height) * b / bands);
+    int last_row = int(int64_t(height) * (b + 1) / bands);
+    if (bands == 1) {
+      trace_band(x_fixed, y_fixed, inc_fixed, max_iterations, iteration_buffer, width, first_row, last_row, stride, &band_stats[b]);
+    }
+    else {
+      workers.emplace_back(trace_band, x_fixed, y_fixed, inc_fixed, max_iterations, iteration_buffer, width, first_row, last_row, stride, &band_stats[b]);
+    }
+  }
+  for (std::thread& worker : workers) {
+    worker.join();
+  }
+  if (stats != nullptr) {
+    *stats = trace_stats();
+    for (const trace_stats& s : band_stats) {
+      stats->iterated += s.iterated;
+      stats->filled += s.filled;
+    }
+  }
+}
@@ -0,0 +1,34 @@
+/* ----------------------------------------------------------
+**
+**
+**   Boundary-tracing renderer
+**
+**   Iterates only the pixels on the contours between regions
+**   of equal iteration count and fills the inside of each
+**   contour from its edge, so the work follows the length of
+**   the boundaries rather than the area. Not exact: a region
+**   with a different count wholly inside another, touching no
+**   traced contour, is filled over. trace_render --audit
+**   measures how often that happens.
+**
+**   Luke Rule
+**
+---------------------------------------------------------- */
+#ifndef BOUNDARY_TRACE_H
+#define BOUNDARY_TRACE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "mandelbrot_renderer.h"
+
+struct trace_stats {
+  uint64_t iterated = 0;    // pixels iterated: the frame edges, contours and their neighbours
+  uint64_t filled = 0;      // pixels given the count of the pixel to their left
+};
+
+// Trace the view into iteration_buffer. With threads > 1 the frame is cut into that many
+// bands of rows, traced independently, whose top and bottom rows are seeded like frame edges.
+void iterateMandelbrotTraced(fixed_32 x_fixed, fixed_32 y_fixed, fixed_32 inc_fixed, int max_iterations, uint16_t* iteration_buffer, int width, int height, size_t stride, int threads = 1, trace_stats* stats = nullptr);
+
+#endif
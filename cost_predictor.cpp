@@ -0,0 +1,85 @@
+/* ----------------------------------------------------------
+**
+**
+**   Render cost prediction by sub-sampling
+**
+**   Luke Rule
+**
+---------------------------------------------------------- */
+#include "cost_predictor.h"
+
+#include <math.h>
+#include <chrono>
+#include <vector>
+#include <algorithm>
+
+uint64_t hardware_cycles(uint64_t iterations, int max_iterations, int width, int height) {
+  uint64_t pixels = uint64_t(width) * height;
+  return iterations + pixels * (RTL_POINT_HANDSHAKE_CYCLES + RTL_PIXEL_OVERHEAD_CYCLES) + max_iterations + RTL_FRAME_SETUP_CYCLES;
+}
+
+cost_prediction predict_render_cost(const coord_step& c, int max_iterations, int width, int height, const cost_model& model, int sample_stride) {
+  cost_prediction p;
+  auto start = std::chrono::steady_clock::now();
+  sample_stride = std::max(1, sample_stride);
+  double iterations = 0.0;
+  for (int by = 0; by < height; by += sample_stride) {
+    int block_height = std::min(sample_stride, height - by);
+    // sample the middle of the block rather than its corner, which sits on the coarse grid lines
+    fixed_32 y_pos = step_coord(c.y, c.step, -(by + block_height / 2));
+    for (int bx = 0; bx < width; bx += sample_stride) {
+      int block_width = std::min(sample_stride, width - bx);
+      int count = iterate_point(step_coord(c.x, c.step, bx + block_width / 2), y_pos, max_iterations);
+      iterations += double(count) * block_width * block_height;
+      p.samples++;
+    }
+  }
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+  double pixels = double(width) * height;
+  p.iterations = uint64_t(llround(iterations));
+  p.seconds = (model.ns_per_iteration * iterations + model.ns_per_pixel * pixels) / 1e9;
+  p.hardware_cycles = hardware_cycles(p.iterations, max_iterations, width, height);
+  p.sample_seconds = elapsed.count();
+  return p;
+}
+
+// best of three full single-threaded renders, and the iterations they took
+static double time_view(Renderer& renderer, const coord_step& c, int max_iterations, uint64_t& iterations) {
+  double best = 1e30;
+  for (int r = 0; r < 3; r++) {
+    auto start = std::chrono::steady_clock::now();
+    renderer.iterate(c, max_iterations, 1);
+    renderer.colourise();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    best = std::min(best, elapsed.count());
+  }
+  iterations = 0;
+  for (int y = 0; y < renderer.height(); y++) {
+    for (int x = 0; x < renderer.width(); x++) {
+      iterations += renderer.iteration_at(x, y);
+    }
+  }
+  return best;
+}
+
+cost_model calibrate_cost_model(int width, int height) {
+  cost_model model;
+  Renderer renderer(width, height);
+  const colour palette[6] = {0x001f, 0x07ff, 0x07e0, 0xffe0, 0xf800, 0xf81f};
+  const int max_iterations = 255;
+  renderer.build_colour_map(palette, max_iterations);
+
+  // mostly escaping in one or two iterations, then mostly inside the main cardioid
+  uint64_t outer_iterations;
+  uint64_t inner_iterations;
+  double outer = time_view(renderer, renderer.view(fixed_32(2 << FRAC_BITS), fixed_32(3 << (FRAC_BITS - 1)), 0), max_iterations, outer_iterations);
+  double inner = time_view(renderer, renderer.view(fixed_32(-(1 << FRAC_BITS) / 10), 0, 4), max_iterations, inner_iterations);
+  double pixels = double(renderer.width()) * renderer.height();
+  if (inner_iterations <= outer_iterations) {
+    return model;
+  }
+  model.ns_per_iteration = (inner - outer) * 1e9 / double(inner_iterations - outer_iterations);
+  model.ns_per_pixel = std::max(0.0, (outer * 1e9 - model.ns_per_iteration * outer_iterations) / pixels);
+  return model;
+}
@@ -0,0 +1,60 @@
+/* ----------------------------------------------------------
+**
+**
+**   Render cost prediction by sub-sampling
+**
+**   Iterates one pixel in every PREDICT_SAMPLE_STRIDE x
+**   PREDICT_SAMPLE_STRIDE block of a view and scales up to the
+**   whole frame: total iterations, model wall time and the
+**   cycle count of the RTL drawing engine.
+**
+**   Luke Rule
+**
+---------------------------------------------------------- */
+#ifndef COST_PREDICTOR_H
+#define COST_PREDICTOR_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "mandelbrot_renderer.h"
+
+// 8x8 blocks, i.e. 1 in 64 pixels
+#define PREDICT_SAMPLE_STRIDE 8
+
+// RTL cycles around each point: request and ack to mandelbrot_point, its final escape check and
+// the done pulse back to the drawing engine
+#define RTL_POINT_HANDSHAKE_CYCLES 4
+// RTL cycles after each point: GET_PIXEL_COLOUR, SET_UP_DRAWING, DRAW_PIXELS with an immediate
+// de_ack, and UPDATE_PIXELS
+#define RTL_PIXEL_OVERHEAD_CYCLES 5
+// RTL cycles per frame outside the pixel loop, besides one colour map entry per iteration level
+#define RTL_FRAME_SETUP_CYCLES 16
+
+// model wall time = ns_per_iteration * iterations + ns_per_pixel * pixels, on one thread
+struct cost_model {
+  double ns_per_iteration = 3.3;
+  double ns_per_pixel = 2.5;
+};
+
+struct cost_prediction {
+  uint64_t iterations = 0;          // predicted total over the frame
+  double seconds = 0.0;             // predicted single-threaded model render time
+  uint64_t hardware_cycles = 0;     // predicted RTL cycles with one point unit
+  size_t samples = 0;               // pixels actually iterated
+  double sample_seconds = 0.0;      // time the prediction itself took
+};
+
+// Predict the cost of rendering a view of width x height. Each sample stands for the pixels of
+// its block, so partial blocks at the right and bottom edges are weighted by their real size.
+cost_prediction predict_render_cost(const coord_step& c, int max_iterations, int width, int height,
+                                    const cost_model& model = cost_model(), int sample_stride = PREDICT_SAMPLE_STRIDE);
+
+// Fit cost_model on this machine from two full renders: an exterior view where the per-pixel
+// cost dominates and an interior view where iterations dominate.
+cost_model calibrate_cost_model(int width = DEFAULT_XSIZE, int height = DEFAULT_YSIZE);
+
+// RTL cycles for a frame with the given total iterations
+uint64_t hardware_cycles(uint64_t iterations, int max_iterations, int width, int height);
+
+#endif
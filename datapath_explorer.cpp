@@ -0,0 +1,134 @@
+/* ----------------------------------------------------------
+**
+**
+**   Point unit datapath explorer
+**
+**   Renders every distinct view of an input file with the RTL
+**   datapath kernel and replays the counts through each
+**   datapath_variant, reporting multipliers, DSP slices,
+**   pipeline depth and predicted iterations per cycle. Every
+**   pixel is also run through the three-multiply kernels, which
+**   must match the five-multiply ones exactly.
+**
+**   usage: datapath_explorer [--input file] [--size WxH]
+**                            [--threads N] [--dsp-per-mult N]
+**
+**   --dsp-per-mult is the DSP slices one 32x32 signed multiply
+**   takes, 4 with 25x18 slices. Iterations per cycle times the
+**   clock a variant closes timing at gives its throughput.
+**   Exits with status 1 if a three-multiply count differs.
+**
+**   Luke Rule
+**
+---------------------------------------------------------- */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <thread>
+#include <algorithm>
+
+#include "mandelbrot_renderer.h"
+#include "batch_render.h"
+#include "point_kernels.h"
+#include "datapath_model.h"
+
+// kernel over count points, thread t taking blocks t, t + threads, ...
+static void run_kernel(point_kernel kernel, const fixed_32* x, const fixed_32* y, size_t count, int max_iterations, uint16_t* iterations, int threads) {
+  auto blocks = [&](int first_block) {
+    for (size_t start = size_t(first_block) * POINT_QUERY_BLOCK; start < count; start += size_t(threads) * POINT_QUERY_BLOCK) {
+      int n = int(std::min<size_t>(POINT_QUERY_BLOCK, count - start));
+      kernel(x + start, y + start, n, max_iterations, iterations + start);
+    }
+  };
+  std::vector<std::thread> workers;
+  for (int t = 1; t < threads; t++) {
+    workers.emplace_back(blocks, t);
+  }
+  blocks(0);
+  for (std::thread& worker : workers) {
+    worker.join();
+  }
+}
+
+static uint64_t count_differences(const std::vector<uint16_t>& a, const std::vector<uint16_t>& b) {
+  uint64_t differ = 0;
+  for (size_t i = 0; i < a.size(); i++) {
+    differ += a[i] != b[i];
+  }
+  return differ;
+}
+
+int main(int argc, char** argv)
+{
+  std::string input_file = "/home/p74644lr/Questa/COMP32211/src/Phase_2/input_file.txt";
+  int width = DEFAULT_XSIZE;
+  int height = DEFAULT_YSIZE;
+  int threads = std::max(1u, std::thread::hardware_concurrency());
+  int dsp_per_mult = 4;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--input") == 0 && i + 1 < argc) {
+      input_file = argv[++i];
+    }
+    else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+      threads = std::max(1, atoi(argv[++i]));
+    }
+    else if (strcmp(argv[i], "--dsp-per-mult") == 0 && i + 1 < argc) {
+      dsp_per_mult = std::max(1, atoi(argv[++i]));
+    }
+    else if (strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+      if (sscanf(argv[++i], "%dx%d", &width, &height) != 2 || width < 1 || height < 1 || width > MAX_XSIZE || height > MAX_YSIZE) {
+        fprintf(stderr, "bad size\n");
+        return 1;
+      }
+    }
+  }
+
+  std::vector<test_case> cases = read_test_cases(input_file);
+  if (cases.empty()) {
+    fprintf(stderr, "no cases in %s\n", input_file.c_str());
+    return 1;
+  }
+  std::vector<geometry_group> groups = plan_geometry_groups(cases, true, width, height);
+  std::vector<datapath_variant> variants = datapath_variants();
+  std::vector<datapath_estimate> estimates(variants.size());
+  size_t pixels = size_t(width) * height;
+  std::vector<fixed_32> x(pixels);
+  std::vector<fixed_32> y(pixels);
+  std::vector<uint16_t> five(pixels);
+  std::vector<uint16_t> three(pixels);
+  uint64_t rtl_differ = 0;
+  uint64_t model_differ = 0;
+  for (const geometry_group& g : groups) {
+    // the pixels in the order the drawing engine requests them
+    for (int row = 0; row < height; row++) {
+      fixed_32 y_pos = step_coord(g.c.y, g.c.step, -row);
+      for (int col = 0; col < width; col++) {
+        x[size_t(row) * width + col] = step_coord(g.c.x, g.c.step, col);
+        y[size_t(row) * width + col] = y_pos;
+      }
+    }
+    run_kernel(scalar_point_kernel, x.data(), y.data(), pixels, g.max_iterations, five.data(), threads);
+    run_kernel(three_mult_point_kernel, x.data(), y.data(), pixels, g.max_iterations, three.data(), threads);
+    model_differ += count_differences(five, three);
+    run_kernel(rtl_point_kernel, x.data(), y.data(), pixels, g.max_iterations, five.data(), threads);
+    run_kernel(rtl_three_mult_point_kernel, x.data(), y.data(), pixels, g.max_iterations, three.data(), threads);
+    rtl_differ += count_differences(five, three);
+    for (size_t v = 0; v < variants.size(); v++) {
+      add_datapath_cycles(variants[v], five.data(), pixels, estimates[v]);
+    }
+  }
+
+  printf("%zu views at %dx%d, counts from the RTL datapath\n\n", groups.size(), width, height);
+  printf("%-22s %5s %5s %6s %6s %10s %10s %7s\n", "variant", "mults", "DSPs", "stages", "points", "iter/cycle", "Mcycles", "vs now");
+  for (size_t v = 0; v < variants.size(); v++) {
+    const datapath_variant& d = variants[v];
+    printf("%-22s %5d %5d %6d %6d %10.3f %10.1f %6.2fx\n", d.name, d.multipliers, d.multipliers * dsp_per_mult, d.stages, d.points,
+           estimates[v].iterations_per_cycle(), estimates[v].cycles / 1e6, double(estimates[0].cycles) / estimates[v].cycles);
+  }
+  printf("\nthree multiplies against five on %zu pixels: model %s, RTL %s\n", pixels * groups.size(),
+         model_differ == 0 ? "bit-exact" : (std::to_string(model_differ) + " differ").c_str(),
+         rtl_differ == 0 ? "bit-exact" : (std::to_string(rtl_differ) + " differ").c_str());
+  return model_differ == 0 && rtl_differ == 0 ? 0 : 1;
+}
@@ -0,0 +1,38 @@
+/* ----------------------------------------------------------
+**
+**
+**   Point unit datapath cost model
+**
+**   Luke Rule
+**
+---------------------------------------------------------- */
+#include "datapath_model.h"
+
+#include <algorithm>
+
+#include "cost_predictor.h"
+
+std::vector<datapath_variant> datapath_variants() {
+  return {
+    {"5 mult (current)", 5, 1, 1},
+    {"3 mult", 3, 1, 1},
+    {"3 mult, 2 stages", 3, 2, 1},
+    {"3 mult, 2 stages x2", 3, 2, 2},
+    {"3 mult, 3 stages", 3, 3, 1},
+    {"3 mult, 3 stages x3", 3, 3, 3},
+  };
+}
+
+void add_datapath_cycles(const datapath_variant& v, const uint16_t* counts, size_t pixels, datapath_estimate& e) {
+  int stages = std::max(1, v.stages);
+  int points = std::max(1, std::min(v.points, stages));
+  // the handshake's cycles rounded up to whole turns of the slot
+  uint64_t handshake_turns = (RTL_POINT_HANDSHAKE_CYCLES + stages - 1) / stages;
+  std::vector<uint64_t> free_turn(points, 0);
+  for (size_t i = 0; i < pixels; i++) {
+    auto slot = std::min_element(free_turn.begin(), free_turn.end());
+    *slot += handshake_turns + counts[i];
+    e.iterations += counts[i];
+  }
+  e.cycles += *std::max_element(free_turn.begin(), free_turn.end()) * stages;
+}
@@ -0,0 +1,46 @@
+/* ----------------------------------------------------------
+**
+**
+**   Point unit datapath cost model
+**
+**   Cycle estimates for variants of mandelbrot_point.sv's
+**   iteration datapath: five multipliers or three shared ones,
+**   with the multipliers pipelined over 1 to 3 stages and up to
+**   one point per stage interleaved through the pipeline. The
+**   estimates replay real iteration counts through the point
+**   unit, so escape times and handshakes are those of a frame.
+**
+**   Luke Rule
+**
+---------------------------------------------------------- */
+#ifndef DATAPATH_MODEL_H
+#define DATAPATH_MODEL_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+struct datapath_variant {
+  const char* name;
+  int multipliers;    // 5 as mandelbrot_point.sv writes them, or 3 with the squares shared
+  int stages;         // cycles from z to the next z, so one point issues every stages cycles
+  int points;         // points interleaved through the stages, 1 to stages
+};
+
+struct datapath_estimate {
+  uint64_t iterations = 0;
+  uint64_t cycles = 0;
+  double iterations_per_cycle() const { return cycles == 0 ? 0.0 : double(iterations) / cycles; }
+};
+
+// the current datapath first, then three multipliers at 1, 2 and 3 stages, alone and interleaved
+std::vector<datapath_variant> datapath_variants();
+
+// Add the point unit cycles for one frame, whose pixels reach the unit in queue order with the
+// given counts. Each of the points slots gets every stages-th cycle. A point holds its slot for
+// its iterations and the RTL_POINT_HANDSHAKE_CYCLES handshake, both in the slot's turns, and
+// the slot that frees first takes the next point. The drawing states after each point are left
+// out: they are the same for every variant.
+void add_datapath_cycles(const datapath_variant& v, const uint16_t* counts, size_t pixels, datapath_estimate& e);
+
+#endif
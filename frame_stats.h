@@ -0,0 +1,79 @@
+/* ----------------------------------------------------------
+**
+**
+**   Optional per-frame rendering statistics
+**
+**   Only compiled in with -DMANDELBROT_STATS. Without it the
+**   Renderer carries no stats and FRAME_STATS(...) expands to
+**   nothing, so the normal build is unchanged.
+**
+**   Luke Rule
+**
+---------------------------------------------------------- */
+#ifndef FRAME_STATS_H
+#define FRAME_STATS_H
+
+// equal-width bins over 0 to max_iterations
+#define STATS_HISTOGRAM_BINS 32
+
+#ifdef MANDELBROT_STATS
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#define FRAME_STATS(...) __VA_ARGS__
+
+struct frame_stats {
+  int width = 0;
+  int height = 0;
+  int max_iterations = 0;
+  uint64_t total_iterations = 0;
+  uint64_t escaped = 0;            // pixels that left the radius 2 circle
+  uint64_t capped = 0;             // pixels that reached max_iterations
+  uint32_t histogram[STATS_HISTOGRAM_BINS] = {};
+  double iterate_us = 0.0;
+  double colour_map_us = 0.0;
+  std::vector<float> row_us;       // row-major layout, one entry per row
+  std::vector<float> tile_us;      // tiled layout, one entry per tile in raster order
+};
+
+inline void append_json_array(std::string& out, const char* name, const std::vector<float>& values) {
+  char number[32];
+  out += ",\"";
+  out += name;
+  out += "\":[";
+  for (size_t i = 0; i < values.size(); i++) {
+    snprintf(number, sizeof(number), i ? ",%.1f" : "%.1f", values[i]);
+    out += number;
+  }
+  out += "]";
+}
+
+// one JSON object on a single line, for a frames.jsonl file
+inline std::string frame_stats_json(const frame_stats& stats, int file_count) {
+  char head[320];
+  snprintf(head, sizeof(head),
+           "{\"file_count\":%d,\"width\":%d,\"height\":%d,\"max_iterations\":%d,\"total_iterations\":%llu,"
+           "\"escaped\":%llu,\"capped\":%llu,\"iterate_us\":%.1f,\"colour_map_us\":%.1f,\"histogram\":[",
+           file_count, stats.width, stats.height, stats.max_iterations, (unsigned long long)stats.total_iterations,
+           (unsigned long long)stats.escaped, (unsigned long long)stats.capped, stats.iterate_us, stats.colour_map_us);
+  std::string out = head;
+  for (int i = 0; i < STATS_HISTOGRAM_BINS; i++) {
+    out += (i ? "," : "") + std::to_string(stats.histogram[i]);
+  }
+  out += "]";
+  append_json_array(out, "row_us", stats.row_us);
+  append_json_array(out, "tile_us", stats.tile_us);
+  out += "}";
+  return out;
+}
+
+#else
+
+#define FRAME_STATS(...)
+
+#endif
+
+#endif
@@ -0,0 +1,190 @@
+/* ----------------------------------------------------------
+**
+**
+**   Shared-memory framebuffer ring
+**
+**   Luke Rule
+**
+---------------------------------------------------------- */
+#include "framebuffer_ring.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static uint32_t align_up(size_t value) {
+  return uint32_t((value + RING_ALIGNMENT - 1) & ~size_t(RING_ALIGNMENT - 1));
+}
+
+static ring_header* get_header(const framebuffer_ring& ring) {
+  return reinterpret_cast<ring_header*>(ring.base);
+}
+
+static ring_slot_header* get_slot(const framebuffer_ring& ring, uint64_t frame_number) {
+  ring_header* header = get_header(ring);
+  // frame numbers are 1-based so the first frame lands in slot 0
+  uint64_t index = (frame_number - 1) % header->slot_count;
+  return reinterpret_cast<ring_slot_header*>(ring.base + align_up(sizeof(ring_header)) + index * header->slot_stride);
+}
+
+bool ring_create(framebuffer_ring& ring, const std::string& name, int slot_count, int max_width, int max_height) {
+  if (slot_count < 2 || max_width <= 0 || max_height <= 0) {
+    return false;
+  }
+  uint32_t pixel_offset = align_up(sizeof(ring_slot_header));
+  uint32_t slot_stride = align_up(pixel_offset + size_t(max_width) * max_height * sizeof(uint16_t));
+  size_t size = align_up(sizeof(ring_header)) + size_t(slot_stride) * slot_count;
+
+  // start from a fresh segment so stale readers of an old layout cannot be confused
+  shm_unlink(name.c_str());
+  int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+  if (fd < 0) {
+    return false;
+  }
+  if (ftruncate(fd, size) != 0) {
+    close(fd);
+    shm_unlink(name.c_str());
+    return false;
+  }
+  void* base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (base == MAP_FAILED) {
+    close(fd);
+    shm_unlink(name.c_str());
+    return false;
+  }
+
+  ring.name = name;
+  ring.fd = fd;
+  ring.size = size;
+  ring.base = static_cast<uint8_t*>(base);
+  ring.writer = true;
+  ring.published = 0;
+
+  // ftruncate zero-fills, so every slot sequence and latest start at 0
+  ring_header* header = get_header(ring);
+  header->slot_count = slot_count;
+  header->max_width = max_width;
+  header->max_height = max_height;
+  header->slot_stride = slot_stride;
+  header->pixel_offset = pixel_offset;
+  header->version = RING_VERSION;
+  // magic last, so a reader never sees a half-initialised header as valid
+  std::atomic_thread_fence(std::memory_order_release);
+  header->magic = RING_MAGIC;
+  return true;
+}
+
+bool ring_open(framebuffer_ring& ring, const std::string& name) {
+  int fd = shm_open(name.c_str(), O_RDONLY, 0);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || size_t(st.st_size) < sizeof(ring_header)) {
+    close(fd);
+    return false;
+  }
+  void* base = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  if (base == MAP_FAILED) {
+    close(fd);
+    return false;
+  }
+
+  ring.name = name;
+  ring.fd = fd;
+  ring.size = st.st_size;
+  ring.base = static_cast<uint8_t*>(base);
+  ring.writer = false;
+
+  ring_header* header = get_header(ring);
+  std::atomic_thread_fence(std::memory_order_acquire);
+  if (header->magic != RING_MAGIC || header->version != RING_VERSION ||
+      align_up(sizeof(ring_header)) + size_t(header->slot_stride) * header->slot_count > ring.size) {
+    ring_close(ring);
+    return false;
+  }
+  return true;
+}
+
+void ring_close(framebuffer_ring& ring) {
+  if (ring.base != nullptr) {
+    munmap(ring.base, ring.size);
+    ring.base = nullptr;
+  }
+  if (ring.fd >= 0) {
+    close(ring.fd);
+    ring.fd = -1;
+  }
+  if (ring.writer) {
+    shm_unlink(ring.name.c_str());
+    ring.writer = false;
+  }
+}
+
+uint16_t* ring_begin_publish(framebuffer_ring& ring) {
+  ring_slot_header* slot = get_slot(ring, ring.published + 1);
+  // odd sequence marks the slot as being written
+  slot->sequence.fetch_add(1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  return reinterpret_cast<uint16_t*>(reinterpret_cast<uint8_t*>(slot) + get_header(ring)->pixel_offset);
+}
+
+void ring_end_publish(framebuffer_ring& ring, ring_frame_meta meta) {
+  ring_header* header = get_header(ring);
+  ring_slot_header* slot = get_slot(ring, ring.published + 1);
+
+  struct timespec ts;
+  clock_gettime(CLOCK_REALTIME, &ts);
+  meta.frame_number = ring.published + 1;
+  meta.timestamp_ns = uint64_t(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+  slot->meta = meta;
+
+  // back to even: the slot is complete
+  slot->sequence.fetch_add(1, std::memory_order_release);
+  ring.published++;
+  header->latest.store(ring.published, std::memory_order_release);
+}
+
+bool ring_publish(framebuffer_ring& ring, const ring_frame_meta& meta, const uint16_t* pixels) {
+  ring_header* header = get_header(ring);
+  if (meta.width > header->max_width || meta.height > header->max_height) {
+    return false;
+  }
+  uint16_t* slot_pixels = ring_begin_publish(ring);
+  memcpy(slot_pixels, pixels, size_t(meta.width) * meta.height * sizeof(uint16_t));
+  ring_end_publish(ring, meta);
+  return true;
+}
+
+bool ring_acquire_latest(const framebuffer_ring& ring, ring_frame_view& view) {
+  ring_header* header = get_header(ring);
+  while (true) {
+    uint64_t latest = header->latest.load(std::memory_order_acquire);
+    if (latest == 0) {
+      return false;
+    }
+    const ring_slot_header* slot = get_slot(ring, latest);
+    uint64_t sequence = slot->sequence.load(std::memory_order_acquire);
+    // the writer is already reusing this slot, so pick up the newer latest
+    if (sequence & 1) {
+      continue;
+    }
+    view.meta = slot->meta;
+    view.pixels = reinterpret_cast<const uint16_t*>(reinterpret_cast<const uint8_t*>(slot) + header->pixel_offset);
+    view.slot = slot;
+    view.sequence = sequence;
+    // metadata copy must be from the same publish as the frame number we asked for
+    if (ring_frame_valid(view) && view.meta.frame_number == latest) {
+      return true;
+    }
+  }
+}
+
+bool ring_frame_valid(const ring_frame_view& view) {
+  std::atomic_thread_fence(std::memory_order_acquire);
+  return view.slot->sequence.load(std::memory_order_relaxed) == view.sequence;
+}
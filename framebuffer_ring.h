@@ -0,0 +1,104 @@
+/* ----------------------------------------------------------
+**
+**
+**   Shared-memory framebuffer ring
+**
+**   Publishes rendered RGB565 frames into a POSIX shared-memory
+**   ring so that viewers and encoders can map them directly
+**
+**   Luke Rule
+**
+---------------------------------------------------------- */
+#ifndef FRAMEBUFFER_RING_H
+#define FRAMEBUFFER_RING_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include <string>
+
+// "MBRG" - identifies a mapped segment as a framebuffer ring
+#define RING_MAGIC 0x4d425247
+#define RING_VERSION 1
+#define RING_DEFAULT_SLOTS 4
+// slots are padded to this so pixel data never shares a cache line with a sequence counter
+#define RING_ALIGNMENT 64
+
+// Layout of the shared segment:
+//   ring_header | slot 0 | slot 1 | ... | slot N-1
+// where each slot is a ring_slot_header followed by max_width * max_height RGB565 pixels.
+//
+// Publish protocol (single writer, any number of readers, no locks):
+//   1. the writer bumps the slot sequence to an odd value before touching the slot
+//   2. metadata and pixels are written
+//   3. the slot sequence is bumped to the next even value (release)
+//   4. the header's latest counter is set to the frame number (release)
+// A reader loads latest, reads the slot sequence, uses the pixels in place and then
+// re-reads the sequence; if it changed (or was odd) the frame was overwritten and is discarded.
+// The writer cycles through the slots, so a reader has slot_count - 1 frame periods to consume a frame.
+
+struct ring_frame_meta {
+  uint64_t frame_number;      // 1-based publish count
+  uint64_t timestamp_ns;      // CLOCK_REALTIME at publish
+  int32_t center_x;           // Q3.29 as read from the input line
+  int32_t center_y;
+  int32_t zoom;
+  int32_t max_iterations;
+  uint16_t colours[6];        // interpolation points, RGB565
+  int32_t file_count;         // matches the output file naming
+  uint32_t width;
+  uint32_t height;
+};
+
+struct ring_slot_header {
+  std::atomic<uint64_t> sequence;
+  ring_frame_meta meta;
+};
+
+struct ring_header {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t slot_count;
+  uint32_t max_width;
+  uint32_t max_height;
+  uint32_t slot_stride;       // bytes between slot headers
+  uint32_t pixel_offset;      // bytes from slot header to first pixel
+  std::atomic<uint64_t> latest;  // frame number of the newest complete frame, 0 if none
+};
+
+struct framebuffer_ring {
+  std::string name;
+  int fd = -1;
+  size_t size = 0;
+  uint8_t* base = nullptr;
+  bool writer = false;
+  uint64_t published = 0;
+};
+
+// a frame as seen by a reader; pixels point straight into the shared mapping
+struct ring_frame_view {
+  ring_frame_meta meta;
+  const uint16_t* pixels;
+  const ring_slot_header* slot;
+  uint64_t sequence;
+};
+
+// create (or replace) a ring called name, e.g. "/mandelbrot_frames"
+bool ring_create(framebuffer_ring& ring, const std::string& name, int slot_count, int max_width, int max_height);
+// map an existing ring read-only
+bool ring_open(framebuffer_ring& ring, const std::string& name);
+// unmap, and unlink the segment if this process created it
+void ring_close(framebuffer_ring& ring);
+
+// zero-copy publish: render straight into the returned slot, then end the publish
+uint16_t* ring_begin_publish(framebuffer_ring& ring);
+void ring_end_publish(framebuffer_ring& ring, ring_frame_meta meta);
+// copying publish for callers that already hold a framebuffer
+bool ring_publish(framebuffer_ring& ring, const ring_frame_meta& meta, const uint16_t* pixels);
+
+// get the newest complete frame; false if no frame has been published yet
+bool ring_acquire_latest(const framebuffer_ring& ring, ring_frame_view& view);
+// check that a frame was not overwritten while it was being used
+bool ring_frame_valid(const ring_frame_view& view);
+
+#endif
@@ -0,0 +1,133 @@
+/* ----------------------------------------------------------
+**
+**
+**   Interleaved scalar kernel benchmark
+**
+**   Renders the benchmark views with the scalar row loop and
+**   with iterateMandelbrotInterleaved for 2 to 8 orbits in
+**   flight, and reports each time against the row loop. Every
+**   count is checked against the row loop. The kernel is for
+**   targets without wide SIMD, so this is the run to repeat
+**   on them to pick the count.
+**
+**   usage: ilp_benchmark [--size WxH] [--threads N]
+**                        [--iterations M] [--reps R]
+**
+**   Luke Rule
+**
+---------------------------------------------------------- */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <functional>
+
+#include "mandelbrot_renderer.h"
+#include "point_kernels.h"
+
+struct ilp_view {
+  const char* name;
+  double x;
+  double y;
+  int zoom;
+};
+
+typedef void (*frame_renderer)(fixed_32, fixed_32, fixed_32, int, uint16_t*, int, int, size_t, int);
+
+static fixed_32 to_fixed(double value) {
+  return fixed_32(int64_t(value * (1 << FRAC_BITS)));
+}
+
+// best wall time of reps runs of work
+static double time_best(int reps, const std::function<void()>& work) {
+  double best = 1e30;
+  for (int r = 0; r < reps; r++) {
+    auto start = std::chrono::steady_clock::now();
+    work();
+    best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+  }
+  return best;
+}
+
+int main(int argc, char** argv)
+{
+  int width = DEFAULT_XSIZE;
+  int height = DEFAULT_YSIZE;
+  int threads = 1;
+  int max_iterations = 511;
+  int reps = 3;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+      threads = std::max(1, atoi(argv[++i]));
+    }
+    else if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+      max_iterations = std::min(MAX_ITERATIONS, std::max(1, atoi(argv[++i])));
+    }
+    else if (strcmp(argv[i], "--reps") == 0 && i + 1 < argc) {
+      reps = std::max(1, atoi(argv[++i]));
+    }
+    else if (strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+      if (sscanf(argv[++i], "%dx%d", &width, &height) != 2 || width < 1 || height < 1 || width > MAX_XSIZE || height > MAX_YSIZE) {
+        fprintf(stderr, "bad size\n");
+        return 1;
+      }
+    }
+  }
+
+  // the fixed windows of test_input_generator.py
+  const ilp_view views[] = {
+    {"full", -0.5, 0.0, 0},
+    {"cardioid_edge", -0.7467, 0.163, 6},
+    {"period2_valley", -0.749, 0.07, 5},
+    {"minibrot", -1.766, 0.0, 5},
+    {"outer_branches", -0.2, -0.865, 3},
+    {"very_zoomed", 0.001643721971153, -0.822467633298876, 8},
+    {"seahorse", -0.745, 0.186, 6},
+    {"elephant", 0.273, 0.007, 7},
+    {"origin", 0.0, 0.0, 0},
+  };
+  const int orbits[] = {2, 4, 6, 8};
+  const frame_renderer renderers[] = {
+    iterateMandelbrotInterleaved<2>, iterateMandelbrotInterleaved<4>, iterateMandelbrotInterleaved<6>, iterateMandelbrotInterleaved<8>,
+  };
+  const int kernels = sizeof(orbits) / sizeof(orbits[0]);
+
+  std::vector<uint16_t> reference(size_t(width) * height);
+  std::vector<uint16_t> buffer(size_t(width) * height);
+  printf("%dx%d, %d iterations, %d threads\n\n", width, height, max_iterations, threads);
+  printf("%-15s %9s", "view", "rows ms");
+  for (int k = 0; k < kernels; k++) {
+    printf(" %7s%d", "x", orbits[k]);
+  }
+  printf("\n");
+  double rows_total = 0.0;
+  std::vector<double> totals(kernels);
+  for (const ilp_view& v : views) {
+    coord_step c = center_coords(to_fixed(v.x), to_fixed(v.y), v.zoom, width, height);
+    double rows = time_best(reps, [&] {
+      iterateMandelbrotParallel(c.x, c.y, c.step, max_iterations, reference.data(), width, height, width, threads);
+    });
+    rows_total += rows;
+    printf("%-15s %9.2f", v.name, rows * 1e3);
+    for (int k = 0; k < kernels; k++) {
+      double seconds = time_best(reps, [&] {
+        renderers[k](c.x, c.y, c.step, max_iterations, buffer.data(), width, height, width, threads);
+      });
+      if (buffer != reference) {
+        fprintf(stderr, "\n%s: %d interleaved orbits differ from the row render\n", v.name, orbits[k]);
+        return 1;
+      }
+      totals[k] += seconds;
+      printf(" %7.2fx", rows / seconds);
+    }
+    printf("\n");
+  }
+  printf("\nall views: rows %.1f ms", rows_total * 1e3);
+  for (int k = 0; k < kernels; k++) {
+    printf(", %d orbits %.2fx", orbits[k], rows_total / totals[k]);
+  }
+  printf("\n");
+  return 0;
+}
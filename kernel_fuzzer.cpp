@@ -0,0 +1,361 @@
+/* ----------------------------------------------------------
+**
+**
+**   Differential fuzzer for the point kernels
+**
+**   Runs random points through every kernel of point_kernels.h
+**   and compares each against the scalar model loop. Points are
+**   drawn uniformly over the Q3.29 range, mutated from earlier
+**   points that escaped slowly (so they crowd the set boundary),
+**   or built from Q3.29 edge values such as +-4.0 and +-2.0. A
+**   mismatch is shrunk to the fewest iterations and the fewest
+**   significant coordinate bits that still show it.
+**
+**   usage: kernel_fuzzer [--kernel name[,name...]] [--seconds S]
+**                        [--points N] [--seed S] [--threads N]
+**                        [--weights U,B,E] [--max-reports K]
+**
+**   Exits with status 1 if any kernel disagrees with the model.
+**   Kernels registered as references are reported but never fail
+**   the run.
+**
+**   Luke Rule
+**
+---------------------------------------------------------- */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <set>
+#include <tuple>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+
+#include "mandelbrot_renderer.h"
+#include "point_kernels.h"
+#include "xoshiro.h"
+
+// points per kernel call; one max_iterations per batch
+#define FUZZ_BATCH 4096
+// slowly escaping points kept for mutation, per thread
+#define FUZZ_POOL_SIZE 4096
+// escape counts at least this high count as near the boundary
+#define FUZZ_BOUNDARY_ITERATIONS 16
+
+enum fuzz_family { FAMILY_UNIFORM, FAMILY_BOUNDARY, FAMILY_EXTREME, FAMILY_COUNT };
+static const char* family_names[FAMILY_COUNT] = {"uniform", "boundary", "extreme"};
+
+struct fuzz_point {
+  fixed_32 x;
+  fixed_32 y;
+  int max_iterations;
+};
+
+// Q3.29 edge values: the ends of the range, the escape radius and the unit points
+static const uint32_t edge_values[] = {
+  0x80000000, 0x7fffffff, 0x40000000, 0xc0000000, 0x20000000, 0xe0000000,
+  0x00000000, 0x60000000, 0xa0000000, 0x10000000, 0xf0000000, 0x08000000,
+};
+
+// limits the RTL traps to, and the ends of the range
+static const int edge_iterations[] = {1, 2, 3, 4, 255, 256, 511, 512, 1022, MAX_ITERATIONS};
+
+static fixed_32 extreme_coordinate(xoshiro256& rng) {
+  uint32_t value = edge_values[rng.below(sizeof(edge_values) / sizeof(edge_values[0]))];
+  switch (rng.below(4)) {
+    case 0:
+      return fixed_32(value);
+    case 1:
+      // a few LSBs either side
+      return fixed_32(value + rng.below(9) - 4);
+    case 2:
+      // wider, but still close on the scale of a zoomed-in pixel
+      return fixed_32(value + uint32_t(int32_t(rng.below(1 << 16)) - (1 << 15)));
+    default:
+      return fixed_32(uint32_t(rng.next()));
+  }
+}
+
+struct fuzz_options {
+  std::vector<const point_kernel_entry*> kernels;
+  double seconds = 10.0;
+  uint64_t points = 0;          // stop after this many points when non-zero
+  uint64_t seed = 1;
+  int threads = 1;
+  int weights[FAMILY_COUNT] = {1, 4, 2};
+  int max_reports = 5;          // shrunk reproducers printed per kernel
+};
+
+struct kernel_result {
+  uint64_t mismatches = 0;
+  uint64_t family_mismatches[FAMILY_COUNT] = {};
+  // shrunk reproducers with the two counts, without repeats
+  std::set<std::tuple<fixed_32, fixed_32, int>> seen;
+  std::vector<std::tuple<fuzz_point, int, int>> reports;
+};
+
+static bool differs(point_kernel kernel, const fuzz_point& p, int& expected, int& got) {
+  uint16_t a;
+  uint16_t b;
+  scalar_point_kernel(&p.x, &p.y, 1, p.max_iterations, &a);
+  kernel(&p.x, &p.y, 1, p.max_iterations, &b);
+  expected = a;
+  got = b;
+  return a != b;
+}
+
+// Smallest limit that still differs, then coordinates with as many low bits cleared as possible.
+// Each accepted step keeps the mismatch, so the result always reproduces.
+static fuzz_point shrink(point_kernel kernel, fuzz_point p) {
+  int expected;
+  int got;
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (int m = 1; m < p.max_iterations; m++) {
+      fuzz_point candidate = {p.x, p.y, m};
+      if (differs(kernel, candidate, expected, got)) {
+        p = candidate;
+        changed = true;
+        break;
+      }
+    }
+    for (int axis = 0; axis < 2; axis++) {
+      fixed_32& value = axis == 0 ? p.x : p.y;
+      for (int bits = 32; bits > 0; bits--) {
+        uint32_t mask = bits == 32 ? 0 : ~((1u << bits) - 1);
+        fixed_32 original = value;
+        value = fixed_32(uint32_t(value) & mask);
+        if (value != original && differs(kernel, p, expected, got)) {
+          changed = true;
+          break;
+        }
+        value = original;
+      }
+    }
+  }
+  return p;
+}
+
+static void fuzz_thread(const fuzz_options& options, int index, std::vector<kernel_result>& results, std::mutex& lock,
+                        std::atomic<uint64_t>& total, std::atomic<bool>& stop) {
+  xoshiro256 rng(options.seed + 0x1000193ULL * index);
+  int weight_total = options.weights[FAMILY_UNIFORM] + options.weights[FAMILY_BOUNDARY] + options.weights[FAMILY_EXTREME];
+  std::vector<uint8_t> families(FUZZ_BATCH);
+  std::vector<fixed_32> x(FUZZ_BATCH);
+  std::vector<fixed_32> y(FUZZ_BATCH);
+  std::vector<uint16_t> expected(FUZZ_BATCH);
+  std::vector<uint16_t> got(FUZZ_BATCH);
+  std::vector<std::pair<fixed_32, fixed_32>> pool;
+  size_t pool_next = 0;
+  // start the pool off with a grid over the interesting window
+  for (int i = 0; i < 64; i++) {
+    for (int j = 0; j < 64; j++) {
+      fixed_32 px = fixed_32((-2.0 + 2.5 * i / 64) * (1 << FRAC_BITS));
+      fixed_32 py = fixed_32((-1.25 + 2.5 * j / 64) * (1 << FRAC_BITS));
+      int n = iterate_point(px, py, 256);
+      if (n >= FUZZ_BOUNDARY_ITERATIONS && n < 256) {
+        pool.push_back({px, py});
+      }
+    }
+  }
+
+  while (!stop.load(std::memory_order_relaxed)) {
+    int max_iterations = rng.below(4) == 0 ? edge_iterations[rng.below(sizeof(edge_iterations) / sizeof(edge_iterations[0]))]
+                                           : 1 + int(rng.below(MAX_ITERATIONS));
+    for (int i = 0; i < FUZZ_BATCH; i++) {
+      int pick = rng.below(weight_total);
+      int family = FAMILY_UNIFORM;
+      while (pick >= options.weights[family]) {
+        pick -= options.weights[family];
+        family++;
+      }
+      if (family == FAMILY_BOUNDARY && pool.empty()) {
+        family = FAMILY_UNIFORM;
+      }
+      families[i] = family;
+      if (family == FAMILY_UNIFORM) {
+        uint64_t bits = rng.next();
+        x[i] = fixed_32(uint32_t(bits));
+        y[i] = fixed_32(uint32_t(bits >> 32));
+      }
+      else if (family == FAMILY_BOUNDARY) {
+        // nudge a slow escaper by up to 2^k LSBs, k from 0 to 24, so steps run from one LSB to 1/32
+        const std::pair<fixed_32, fixed_32>& base = pool[rng.below(pool.size())];
+        int k = rng.below(25);
+        uint32_t span = 1u << k;
+        x[i] = fixed_32(uint32_t(base.first) + rng.below(2 * span + 1) - span);
+        y[i] = fixed_32(uint32_t(base.second) + rng.below(2 * span + 1) - span);
+      }
+      else {
+        x[i] = extreme_coordinate(rng);
+        y[i] = extreme_coordinate(rng);
+      }
+    }
+
+    scalar_point_kernel(x.data(), y.data(), FUZZ_BATCH, max_iterations, expected.data());
+    for (int i = 0; i < FUZZ_BATCH; i++) {
+      if (expected[i] >= FUZZ_BOUNDARY_ITERATIONS && expected[i] < max_iterations) {
+        if (pool.size() < FUZZ_POOL_SIZE) {
+          pool.push_back({x[i], y[i]});
+        }
+        else {
+          pool[pool_next] = {x[i], y[i]};
+          pool_next = (pool_next + 1) % FUZZ_POOL_SIZE;
+        }
+      }
+    }
+
+    for (size_t k = 0; k < options.kernels.size(); k++) {
+      options.kernels[k]->kernel(x.data(), y.data(), FUZZ_BATCH, max_iterations, got.data());
+      if (memcmp(expected.data(), got.data(), FUZZ_BATCH * sizeof(uint16_t)) == 0) {
+        continue;
+      }
+      for (int i = 0; i < FUZZ_BATCH; i++) {
+        if (expected[i] == got[i]) {
+          continue;
+        }
+        fuzz_point small = shrink(options.kernels[k]->kernel, {x[i], y[i], max_iterations});
+        int a;
+        int b;
+        differs(options.kernels[k]->kernel, small, a, b);
+        std::lock_guard<std::mutex> guard(lock);
+        kernel_result& r = results[k];
+        r.mismatches++;
+        r.family_mismatches[families[i]]++;
+        if (r.seen.insert(std::make_tuple(small.x, small.y, small.max_iterations)).second && int(r.reports.size()) < options.max_reports) {
+          r.reports.push_back(std::make_tuple(small, a, b));
+        }
+      }
+    }
+
+    uint64_t done = total.fetch_add(FUZZ_BATCH) + FUZZ_BATCH;
+    if (options.points != 0 && done >= options.points) {
+      stop = true;
+    }
+  }
+}
+
+static double to_double(fixed_32 value) {
+  return double(value) / (1 << FRAC_BITS);
+}
+
+int main(int argc, char** argv)
+{
+  fuzz_options options;
+  std::string kernel_names;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--kernel") == 0 && i + 1 < argc) {
+      kernel_names = argv[++i];
+    }
+    else if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+      options.seconds = atof(argv[++i]);
+    }
+    else if (strcmp(argv[i], "--points") == 0 && i + 1 < argc) {
+      options.points = strtoull(argv[++i], nullptr, 10);
+    }
+    else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+      options.seed = strtoull(argv[++i], nullptr, 0);
+    }
+    else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+      options.threads = atoi(argv[++i]);
+      if (options.threads <= 0) {
+        options.threads = std::max(1u, std::thread::hardware_concurrency());
+      }
+    }
+    else if (strcmp(argv[i], "--weights") == 0 && i + 1 < argc) {
+      int* w = options.weights;
+      if (sscanf(argv[++i], "%d,%d,%d", &w[0], &w[1], &w[2]) != 3 || w[0] < 0 || w[1] < 0 || w[2] < 0 || w[0] + w[1] + w[2] == 0) {
+        fprintf(stderr, "bad weights %s, expected uniform,boundary,extreme\n", argv[i]);
+        return 1;
+      }
+    }
+    else if (strcmp(argv[i], "--max-reports") == 0 && i + 1 < argc) {
+      options.max_reports = std::max(0, atoi(argv[++i]));
+    }
+  }
+
+  // every kernel but the scalar one it is compared against, unless chosen
+  for (const point_kernel_entry& k : point_kernels()) {
+    if (kernel_names.empty() && k.kernel != scalar_point_kernel) {
+      options.kernels.push_back(&k);
+    }
+  }
+  size_t start = 0;
+  while (!kernel_names.empty() && start <= kernel_names.size()) {
+    size_t comma = kernel_names.find(',', start);
+    std::string name = kernel_names.substr(start, comma == std::string::npos ? std::string::npos : comma - start);
+    const point_kernel_entry* k = find_point_kernel(name);
+    if (k == nullptr) {
+      fprintf(stderr, "no kernel called %s, have:", name.c_str());
+      for (const point_kernel_entry& e : point_kernels()) {
+        fprintf(stderr, " %s", e.name);
+      }
+      fprintf(stderr, "\n");
+      return 1;
+    }
+    options.kernels.push_back(k);
+    if (comma == std::string::npos) {
+      break;
+    }
+    start = comma + 1;
+  }
+  if (options.kernels.empty()) {
+    fprintf(stderr, "no kernels to compare\n");
+    return 1;
+  }
+
+  std::vector<kernel_result> results(options.kernels.size());
+  std::mutex lock;
+  std::atomic<uint64_t> total(0);
+  std::atomic<bool> stop(false);
+  auto begin = std::chrono::steady_clock::now();
+  std::vector<std::thread> workers;
+  for (int t = 0; t < options.threads; t++) {
+    workers.emplace_back(fuzz_thread, std::cref(options), t, std::ref(results), std::ref(lock), std::ref(total), std::ref(stop));
+  }
+  if (options.points == 0) {
+    while (std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count() < options.seconds) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    stop = true;
+  }
+  for (std::thread& w : workers) {
+    w.join();
+  }
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+  printf("%llu points in %.2f s on %d threads: %.2f M points/s through %zu kernels, seed %llu\n\n",
+         (unsigned long long)total.load(), seconds, options.threads, total.load() / seconds / 1e6, options.kernels.size() + 1,
+         (unsigned long long)options.seed);
+  bool failed = false;
+  for (size_t k = 0; k < options.kernels.size(); k++) {
+    const point_kernel_entry& entry = *options.kernels[k];
+    const kernel_result& r = results[k];
+    printf("%-10s %s%s: ", entry.name, entry.description, entry.reference ? " (reference)" : "");
+    if (r.mismatches == 0) {
+      printf("agrees\n");
+      continue;
+    }
+    // reference kernels are expected to differ from the model; their mismatches are reported, not failures
+    if (!entry.reference) {
+      failed = true;
+    }
+    printf("%llu mismatches (%s %llu, %s %llu, %s %llu), %zu distinct after shrinking\n", (unsigned long long)r.mismatches,
+           family_names[0], (unsigned long long)r.family_mismatches[0], family_names[1], (unsigned long long)r.family_mismatches[1],
+           family_names[2], (unsigned long long)r.family_mismatches[2], r.seen.size());
+    for (const auto& report : r.reports) {
+      const fuzz_point& p = std::get<0>(report);
+      printf("  c = 0x%08x 0x%08x (%.9f, %.9f), max_iterations %d: scalar %d, %s %d\n", uint32_t(p.x), uint32_t(p.y),
+             to_double(p.x), to_double(p.y), p.max_iterations, std::get<1>(report), entry.name, std::get<2>(report));
+      // the centre pixel of a frame gets c = centre exactly
+      printf("    input line (pixel %d,%d): 0x%08x 0x%08x %d %d 0xf800 0x07e0 0x001f 0xfc00 0x03ff 0xf81f 0\n",
+             DEFAULT_XSIZE / 2, DEFAULT_YSIZE / 2, uint32_t(p.x), uint32_t(p.y), MAX_ZOOM, p.max_iterations);
+    }
+  }
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,125 @@
+/* ----------------------------------------------------------
+**
+**
+**   SIMD lane occupancy benchmark
+**
+**   Renders the benchmark views with iterateMandelbrotSIMD on
+**   both lane schedules, fixed groups and refill from the pixel
+**   queue, and reports the share of lane slots doing useful
+**   iterations and the time against the scalar row loop. Every
+**   count is checked against the row loop.
+**
+**   usage: lane_benchmark [--size WxH] [--threads N]
+**                         [--iterations M] [--reps R]
+**
+**   Luke Rule
+**
+---------------------------------------------------------- */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include <functional>
+
+#include "mandelbrot_renderer.h"
+#include "point_kernels.h"
+
+struct lane_view {
+  const char* name;
+  double x;
+  double y;
+  int zoom;
+};
+
+static fixed_32 to_fixed(double value) {
+  return fixed_32(int64_t(value * (1 << FRAC_BITS)));
+}
+
+// best wall time of reps runs of work
+static double time_best(int reps, const std::function<void()>& work) {
+  double best = 1e30;
+  for (int r = 0; r < reps; r++) {
+    auto start = std::chrono::steady_clock::now();
+    work();
+    best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+  }
+  return best;
+}
+
+int main(int argc, char** argv)
+{
+  int width = DEFAULT_XSIZE;
+  int height = DEFAULT_YSIZE;
+  int threads = 1;
+  int max_iterations = 511;
+  int reps = 3;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+      threads = std::max(1, atoi(argv[++i]));
+    }
+    else if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+      max_iterations = std::min(MAX_ITERATIONS, std::max(1, atoi(argv[++i])));
+    }
+    else if (strcmp(argv[i], "--reps") == 0 && i + 1 < argc) {
+      reps = std::max(1, atoi(argv[++i]));
+    }
+    else if (strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+      if (sscanf(argv[++i], "%dx%d", &width, &height) != 2 || width < 1 || height < 1 || width > MAX_XSIZE || height > MAX_YSIZE) {
+        fprintf(stderr, "bad size\n");
+        return 1;
+      }
+    }
+  }
+
+  // the fixed windows of test_input_generator.py
+  const lane_view views[] = {
+    {"full", -0.5, 0.0, 0},
+    {"cardioid_edge", -0.7467, 0.163, 6},
+    {"period2_valley", -0.749, 0.07, 5},
+    {"minibrot", -1.766, 0.0, 5},
+    {"outer_branches", -0.2, -0.865, 3},
+    {"very_zoomed", 0.001643721971153, -0.822467633298876, 8},
+    {"seahorse", -0.745, 0.186, 6},
+    {"elephant", 0.273, 0.007, 7},
+    {"origin", 0.0, 0.0, 0},
+  };
+
+  std::vector<uint16_t> reference(size_t(width) * height);
+  std::vector<uint16_t> buffer(size_t(width) * height);
+  printf("%dx%d, %d iterations, %d threads\n\n", width, height, max_iterations, threads);
+  printf("%-15s %9s %11s %9s %11s %9s %8s\n", "view", "rows ms", "fixed occ", "fixed ms", "refill occ", "refill ms", "speedup");
+  double rows_total = 0.0;
+  double fixed_total = 0.0;
+  double refill_total = 0.0;
+  int lanes = 0;
+  for (const lane_view& v : views) {
+    coord_step c = center_coords(to_fixed(v.x), to_fixed(v.y), v.zoom, width, height);
+    double rows = time_best(reps, [&] {
+      iterateMandelbrotParallel(c.x, c.y, c.step, max_iterations, reference.data(), width, height, width, threads);
+    });
+    lane_stats stats[2];
+    double seconds[2];
+    simd_schedule schedules[2] = {SIMD_FIXED_GROUPS, SIMD_REFILL};
+    for (int s = 0; s < 2; s++) {
+      seconds[s] = time_best(reps, [&] {
+        iterateMandelbrotSIMD(c.x, c.y, c.step, max_iterations, buffer.data(), width, height, width, threads, schedules[s], &stats[s]);
+      });
+      if (buffer != reference) {
+        fprintf(stderr, "%s: %s schedule differs from the row render\n", v.name, s == 0 ? "fixed group" : "refill");
+        return 1;
+      }
+    }
+    lanes = stats[1].lanes;
+    rows_total += rows;
+    fixed_total += seconds[0];
+    refill_total += seconds[1];
+    printf("%-15s %9.2f %10.1f%% %9.2f %10.1f%% %9.2f %7.2fx\n", v.name, rows * 1e3, 100.0 * stats[0].occupancy(), seconds[0] * 1e3,
+           100.0 * stats[1].occupancy(), seconds[1] * 1e3, seconds[0] / seconds[1]);
+  }
+  printf("\n%d lanes; all views: rows %.1f ms, fixed groups %.1f ms (%.2fx rows), refill %.1f ms (%.2fx rows, %.2fx fixed groups)\n", lanes,
+         rows_total * 1e3, fixed_total * 1e3, rows_total / fixed_total, refill_total * 1e3, rows_total / refill_total, fixed_total / refill_total);
+  return 0;
+}
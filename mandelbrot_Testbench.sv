@@ -243,8 +243,8 @@ module unit_Testbench ();
                 if ({framestore_golden[i * `BYTES_PER_PIXEL + 1], framestore_golden[i * `BYTES_PER_PIXEL]} !== {framestore_test[i * `BYTES_PER_PIXEL + 1], framestore_test[i * `BYTES_PER_PIXEL]}) begin
                     pixel_accurate = 1'b0;
                     $fwrite(pixel_error_file, "Pixel mismatch at %0d, %0d. Expected: %0d, got: %0d\n",
-                            (i / `BYTES_PER_PIXEL) % `SCREEN_WIDTH,
-                            (i / `BYTES_PER_PIXEL) / `SCREEN_WIDTH,
+                            i % `SCREEN_WIDTH,
+                            i / `SCREEN_WIDTH,
                             {framestore_golden[i * `BYTES_PER_PIXEL + 1], framestore_golden[i * `BYTES_PER_PIXEL]},
                             {framestore_test[i * `BYTES_PER_PIXEL + 1], framestore_test[i * `BYTES_PER_PIXEL]}
                     );
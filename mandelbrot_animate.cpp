@@ -0,0 +1,137 @@
+/* ----------------------------------------------------------
+**
+**
+**   Zoom-path animation tool
+**
+**   Renders a zoom along keyframes and streams raw RGB24 frames
+**   to an encoder command, a file or nowhere (for timing), then
+**   reports frames per second and how many pixels were reused.
+**
+**   usage: mandelbrot_animate [--path seahorse|elephant] [--key x,y,zoom,frames]...
+**                             [--size WxH] [--max-iterations N] [--threads N]
+**                             [--chunk N] [--no-snap] [--steps-per-octave N]
+**                             [--encoder "command"] [--output file.rgb|-]
+**
+**   e.g. --encoder "ffmpeg -f rawvideo -pix_fmt rgb24 -s 640x480 -r 30 -i - zoom.mp4"
+**
+**   Luke Rule
+**
+---------------------------------------------------------- */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <vector>
+#include <string>
+#include <thread>
+#include <algorithm>
+
+#include "mandelbrot_renderer.h"
+#include "zoom_animation.h"
+
+// from the full view at zoom 0 to zoom 10 on the seahorse or elephant window of test_input_generator.py
+static std::vector<zoom_keyframe> preset_path(const std::string& name) {
+  if (name == "elephant") {
+    return {{-0.5, 0.0, 0.0, 150}, {0.273, 0.007, 10.0, 0}};
+  }
+  return {{-0.5, 0.0, 0.0, 150}, {-0.745, 0.186, 10.0, 0}};
+}
+
+int main(int argc, char** argv)
+{
+  animation_options options;
+  std::vector<zoom_keyframe> keyframes;
+  std::string path = "seahorse";
+  std::string encoder;
+  std::string output;
+  bool snap = true;
+  int steps_per_octave = ANIMATION_REFERENCE_FRAMES;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--path") == 0 && i + 1 < argc) {
+      path = argv[++i];
+    }
+    else if (strcmp(argv[i], "--key") == 0 && i + 1 < argc) {
+      zoom_keyframe k = {0.0, 0.0, 0.0, 0};
+      if (sscanf(argv[++i], "%lf,%lf,%lf,%d", &k.center_x, &k.center_y, &k.zoom, &k.frames) < 3) {
+        fprintf(stderr, "bad keyframe %s, expected x,y,zoom[,frames]\n", argv[i]);
+        return 1;
+      }
+      keyframes.push_back(k);
+    }
+    else if (strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+      if (sscanf(argv[++i], "%dx%d", &options.width, &options.height) != 2 ||
+          options.width < 1 || options.height < 1 || options.width > MAX_XSIZE || options.height > MAX_YSIZE) {
+        fprintf(stderr, "bad size %s, expected WxH up to %dx%d\n", argv[i], MAX_XSIZE, MAX_YSIZE);
+        return 1;
+      }
+    }
+    else if (strcmp(argv[i], "--max-iterations") == 0 && i + 1 < argc) {
+      options.max_iterations = atoi(argv[++i]);
+    }
+    else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+      options.threads = atoi(argv[++i]);
+    }
+    else if (strcmp(argv[i], "--chunk") == 0 && i + 1 < argc) {
+      options.chunk_frames = atoi(argv[++i]);
+    }
+    else if (strcmp(argv[i], "--no-snap") == 0) {
+      snap = false;
+    }
+    else if (strcmp(argv[i], "--steps-per-octave") == 0 && i + 1 < argc) {
+      steps_per_octave = std::max(0, atoi(argv[++i]));
+    }
+    else if (strcmp(argv[i], "--encoder") == 0 && i + 1 < argc) {
+      encoder = argv[++i];
+    }
+    else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+      output = argv[++i];
+    }
+  }
+  if (keyframes.empty()) {
+    keyframes = preset_path(path);
+  }
+  if (options.threads <= 0) {
+    options.threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  // an encoder that exits early shows up as a failed write rather than a signal
+  signal(SIGPIPE, SIG_IGN);
+  FILE* stream = nullptr;
+  if (!encoder.empty()) {
+    stream = popen(encoder.c_str(), "w");
+  }
+  else if (!output.empty()) {
+    stream = output == "-" ? stdout : fopen(output.c_str(), "wb");
+  }
+  if ((!encoder.empty() || !output.empty()) && stream == nullptr) {
+    fprintf(stderr, "could not open %s\n", encoder.empty() ? output.c_str() : encoder.c_str());
+    return 1;
+  }
+
+  std::vector<coord_step> frames = plan_zoom_path(keyframes, options.width, options.height, snap, steps_per_octave);
+  std::vector<uint8_t> rgb;
+  animation_stats stats = render_animation(frames, options, [&](int, const colour* framebuffer, int width, int height) {
+    if (stream == nullptr) {
+      return true;
+    }
+    size_t pixels = size_t(width) * height;
+    rgb.resize(pixels * 3);
+    for (size_t i = 0; i < pixels; i++) {
+      rgb[i * 3] = RED(framebuffer[i]) << 3;
+      rgb[i * 3 + 1] = GREEN(framebuffer[i]) << 2;
+      rgb[i * 3 + 2] = BLUE(framebuffer[i]) << 3;
+    }
+    // a closed pipe (encoder exited) stops the render
+    return fwrite(rgb.data(), 1, rgb.size(), stream) == rgb.size();
+  });
+
+  int status = 0;
+  if (stream != nullptr) {
+    status = !encoder.empty() ? pclose(stream) : (stream == stdout ? fflush(stream) : fclose(stream));
+  }
+  fprintf(stderr, "%zu/%zu frames at %dx%d in %.3f s: %.2f fps, %.1f%% of pixels reused\n",
+          stats.frames, frames.size(), options.width, options.height, stats.seconds,
+          stats.seconds > 0 ? stats.frames / stats.seconds : 0.0,
+          stats.pixels ? 100.0 * stats.reused_pixels / stats.pixels : 0.0);
+  return (stats.frames == frames.size() && status == 0) ? 0 : 1;
+}
@@ -0,0 +1,137 @@
+/* ----------------------------------------------------------
+**
+**
+**   Algorithmic level model of Drawing engine - fixed point core
+**
+**   Drawing engine module: Mandelbrot: fixed point Q3.29
+**
+**   Luke Rule
+**
+---------------------------------------------------------- */
+#ifndef MANDELBROT_FIXED_H
+#define MANDELBROT_FIXED_H
+
+#include <stdint.h>
+
+// Difference between point positions at zoom level 10
+#define BASE_INCREMENT_AMOUNT 0x00000fa0
+#define MAX_ZOOM 10
+// Iteration limit, as trapped by the RTL
+#define MAX_ITERATIONS 1023
+// Q3.29 format
+#define FRAC_BITS 29
+
+// Macros to extract RGB components from RGB565 colour
+#define RED(colour)   ((colour >> 11) & 0x1F)
+#define GREEN(colour) ((colour >> 5) & 0x3F)
+#define BLUE(colour)  (colour & 0x1F)
+
+// Type definitions for reading clarity
+using fixed_64 = int64_t;
+using fixed_32 = int32_t;
+using unsigned_fixed_32 = uint32_t;
+using unsigned_fixed_64 = uint64_t;
+using colour = uint16_t;
+
+struct coord_step {
+  fixed_32 x;
+  fixed_32 y;
+  fixed_32 step;
+};
+
+// fixed point multiplication function for Q3.29 format
+inline fixed_64 fixed_mult(fixed_64 a, fixed_64 b)
+{
+  return ((a * b) >> FRAC_BITS);
+}
+
+// pixel coordinates wrap at 32 bits, exactly as the accumulating position registers in the RTL do
+inline fixed_32 step_coord(fixed_32 start, fixed_32 inc_fixed, int steps) {
+  return fixed_32(unsigned_fixed_32(start) + unsigned_fixed_32(inc_fixed) * unsigned_fixed_32(steps));
+}
+
+// iterate the mandelbrot equation for a single point c = x_fixed + y_fixed i
+inline int iterate_point(fixed_32 x_fixed, fixed_32 y_fixed, int max_iterations) {
+  int iterations = 0;
+  fixed_64 zr = 0;
+  fixed_64 zi = 0;
+  unsigned_fixed_64 modulus_sq = 0;
+
+  // iterate mandelbrot equation until modulus > 2 or max iterations reached
+  while ((modulus_sq <= (4ULL << FRAC_BITS)) && (iterations < max_iterations)) {
+    modulus_sq = fixed_mult(zr,zr) + fixed_mult(zi,zi);
+    // temp to not overwrite zr before calculating zi
+    fixed_64 temp = fixed_mult(zr,zr) - fixed_mult(zi,zi) + x_fixed;
+    zi = (fixed_mult(zr,zi) << 1) + y_fixed;
+    zr = temp;
+    iterations++;
+  }
+  return iterations;
+}
+
+// Iterate c = x_fixed + y_fixed i and its mirror image x_fixed + mirror_y i, giving exactly what
+// iterate_point gives each. Squares and sums mirror exactly, only the floor of zr.zi does not, so
+// while every zr.zi product is a whole Q3.29 number the mirror orbit is conj(z) and its count is
+// copied. From the first inexact product the mirror image starts from conj(z) and the two are
+// iterated in lockstep, so the two independent dependency chains overlap.
+inline int iterate_point_pair(fixed_32 x_fixed, fixed_32 y_fixed, fixed_32 mirror_y, int max_iterations, int* mirror_iterations) {
+  int iterations = 0;
+  fixed_64 zr = 0;
+  fixed_64 zi = 0;
+  unsigned_fixed_64 modulus_sq = 0;
+
+  if (fixed_64(mirror_y) == -fixed_64(y_fixed)) {
+    while ((modulus_sq <= (4ULL << FRAC_BITS)) && (iterations < max_iterations)) {
+      fixed_64 product = zr * zi;
+      // INT64_MIN is its own negation, so it does not mirror either
+      if ((product & ((1LL << FRAC_BITS) - 1)) != 0 || product == INT64_MIN) {
+        break;
+      }
+      modulus_sq = fixed_mult(zr,zr) + fixed_mult(zi,zi);
+      fixed_64 temp = fixed_mult(zr,zr) - fixed_mult(zi,zi) + x_fixed;
+      zi = ((product >> FRAC_BITS) << 1) + y_fixed;
+      zr = temp;
+      iterations++;
+    }
+    if ((modulus_sq > (4ULL << FRAC_BITS)) || (iterations >= max_iterations)) {
+      *mirror_iterations = iterations;
+      return iterations;
+    }
+  }
+  int mirror = iterations;
+  fixed_64 wr = zr;
+  fixed_64 wi = fixed_64(0 - unsigned_fixed_64(zi));
+  unsigned_fixed_64 mirror_modulus_sq = modulus_sq;
+
+  while ((modulus_sq <= (4ULL << FRAC_BITS)) && (mirror_modulus_sq <= (4ULL << FRAC_BITS)) && (iterations < max_iterations)) {
+    modulus_sq = fixed_mult(zr,zr) + fixed_mult(zi,zi);
+    mirror_modulus_sq = fixed_mult(wr,wr) + fixed_mult(wi,wi);
+    fixed_64 temp = fixed_mult(zr,zr) - fixed_mult(zi,zi) + x_fixed;
+    fixed_64 mirror_temp = fixed_mult(wr,wr) - fixed_mult(wi,wi) + x_fixed;
+    zi = (fixed_mult(zr,zi) << 1) + y_fixed;
+    wi = (fixed_mult(wr,wi) << 1) + mirror_y;
+    zr = temp;
+    wr = mirror_temp;
+    iterations++;
+  }
+  // the two escape apart now and then, finish whichever is left
+  mirror = iterations;
+  while ((modulus_sq <= (4ULL << FRAC_BITS)) && (iterations < max_iterations)) {
+    modulus_sq = fixed_mult(zr,zr) + fixed_mult(zi,zi);
+    fixed_64 temp = fixed_mult(zr,zr) - fixed_mult(zi,zi) + x_fixed;
+    zi = (fixed_mult(zr,zi) << 1) + y_fixed;
+    zr = temp;
+    iterations++;
+  }
+  while ((mirror_modulus_sq <= (4ULL << FRAC_BITS)) && (mirror < max_iterations)) {
+    mirror_modulus_sq = fixed_mult(wr,wr) + fixed_mult(wi,wi);
+    fixed_64 temp = fixed_mult(wr,wr) - fixed_mult(wi,wi) + x_fixed;
+    wi = (fixed_mult(wr,wi) << 1) + mirror_y;
+    wr = temp;
+    mirror++;
+  }
+  *mirror_iterations = mirror;
+  return iterations;
+}
+
+#endif
@@ -0,0 +1,471 @@
+/* ----------------------------------------------------------
+**
+**
+**   Algorithmic level model of Drawing engine - renderer library
+**
+**   Drawing engine module: Mandelbrot: fixed point Q3.29
+**
+**   Luke Rule
+**
+---------------------------------------------------------- */
+#include "mandelbrot_renderer.h"
+
+#include <stdio.h>
+#include <math.h>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+
+// Function to spread colour indices more evenly across the colour map
+int get_spread_colour_index(int iterations, int max_iterations) {
+  if (max_iterations < 16) {
+    return iterations;
+  }
+  int spread_value = iterations * ((max_iterations >> 4) - (max_iterations >> 5) - (max_iterations >> 6) - (max_iterations >> 10));
+  if (spread_value < max_iterations) {
+    return spread_value;
+  }
+  else {
+    return max_iterations - 1;
+  }
+}
+
+// taking in 6 interpolation points, generate all unique colours between them
+void generate_unique_colours(std::vector<colour>& unique_colours, std::vector<colour>& interp_points) {
+  for (int i = 0; i < 5; i++) {
+    // get start and end colours for this segment
+    colour colour_start = interp_points.at(i);
+    colour colour_end = interp_points.at(i + 1);
+
+    // extract RGB components
+    uint16_t r = RED(colour_start);
+    uint16_t g = GREEN(colour_start);
+    uint16_t b = BLUE(colour_start);
+    
+    // determine interpolation direction for each component
+    int b_inc = (BLUE(colour_end) - BLUE(colour_start)) > 0 ? 1 : -1;
+    int g_inc = (GREEN(colour_end) - GREEN(colour_start)) > 0 ? 1 : -1;
+    int r_inc = (RED(colour_end) - RED(colour_start)) > 0 ? 1 : -1;
+
+    // add the start colour (this means no divide by zero issues later)
+    unique_colours.push_back(colour_start);
+    // interpolate until we reach the end colour, adding that too
+    while (colour_start != colour_end) {
+      // increment each component if not at the end value
+      // for a smooth gradient they must all be incremented at once, if possible
+      if (r != RED(colour_end)) {
+        r += r_inc;
+      }
+      if (g != GREEN(colour_end)) {
+        g += g_inc;
+      }
+      if (b != BLUE(colour_end)) {
+        b += b_inc;
+      }
+
+      // recombine into RGB565 format
+      colour_start = (r << 11) | (g << 5) | b;
+      unique_colours.push_back(colour_start);
+    }
+  }
+}
+
+void generate_colour_map(int max_iterations, std::vector<colour>& unique_colours, std::vector<colour>& colour_map) {
+  int colour_index = 0;
+  // calculate the best way to evenly sample the unique colours to fill the colour map
+  // if we need to miss out some unique colours
+  if (unique_colours.size() > max_iterations) {
+    int step_size = int(unique_colours.size() / max_iterations);
+    for (int i = 0; i < max_iterations; i++) {
+      // add colour for every iteration
+      colour_map.push_back(unique_colours.at(colour_index));
+      // increment colour index by maximum amount to not exceed max iterations
+      colour_index += step_size;
+    }
+  }
+  // if we need to repeat some unique colours
+  else {
+    // get the max step size to fill the colour map evenly without exceeding unique colours size
+    int step_size = std::ceil(double(max_iterations) / double(unique_colours.size()));
+    for (int i = 0; i < max_iterations; i++) {
+      // add colour for every iteration
+      colour_map.push_back(unique_colours.at(colour_index));
+      // if at step size, increment colour index
+      if ((i + 1) % step_size == 0) {
+        colour_index++;
+      }
+    }
+  }
+}
+
+// get colour from colour map based on iterations
+colour iteration_colour(int iterations, int max_iterations, const std::vector<colour>& colour_map) {
+  if (iterations < max_iterations){
+    return colour_map.at(get_spread_colour_index(iterations, max_iterations));
+  }
+  else{
+    return 0;
+  }
+}
+
+// calculate the top-left coordinates and step size based on center coords and zoom level
+coord_step center_coords(fixed_32 center_x, fixed_32 center_y, int zoom, int width, int height) {
+  coord_step c;
+  if (zoom > MAX_ZOOM) {
+    zoom = 0; // as unsigned in verilog
+  }
+  else if (zoom < 0) {
+    zoom = 0;
+  }
+  fixed_32 step_size = BASE_INCREMENT_AMOUNT * (1 << (MAX_ZOOM - zoom));
+  c.x = step_coord(center_x, step_size, -(width >> 1));
+  c.y = step_coord(center_y, step_size, height >> 1);
+  c.step = step_size;
+  return c;
+}
+
+void drawMandelbrot(fixed_32 x_fixed, fixed_32 y_fixed, fixed_32 inc_fixed, int max_iterations, colour* framebuffer, int width, int height, size_t stride, const std::vector<colour>& colour_map) {
+  fixed_32 x_start = x_fixed;
+  for (int y = 0; y < height; y++){   
+    colour* row = framebuffer + y * stride;
+    for (int x = 0; x < width; x++) {
+      row[x] = iteration_colour(iterate_point(x_fixed, y_fixed, max_iterations), max_iterations, colour_map);
+      x_fixed = step_coord(x_fixed, inc_fixed, 1);
+    }
+    y_fixed = step_coord(y_fixed, inc_fixed, -1);
+    x_fixed = x_start;
+  }
+}
+
+void iterateMandelbrotRows(fixed_32 x_fixed, fixed_32 y_fixed, fixed_32 inc_fixed, int max_iterations, uint16_t* iteration_buffer, int width, int height, size_t stride, int first_row, int row_step) {
+  for (int y = first_row; y < height; y += row_step) {
+    uint16_t* row = iteration_buffer + y * stride;
+    fixed_32 y_pos = step_coord(y_fixed, inc_fixed, -y);
+    fixed_32 x_pos = x_fixed;
+    for (int x = 0; x < width; x++) {
+      row[x] = iterate_point(x_pos, y_pos, max_iterations);
+      x_pos = step_coord(x_pos, inc_fixed, 1);
+    }
+  }
+}
+
+void iterateMandelbrotRect(fixed_32 x_fixed, fixed_32 y_fixed, fixed_32 inc_fixed, int max_iterations, const pixel_rect& rect, uint16_t* out, size_t stride) {
+  for (int y = 0; y < rect.height; y++) {
+    uint16_t* row = out + y * stride;
+    fixed_32 y_pos = step_coord(y_fixed, inc_fixed, -(rect.y + y));
+    for (int x = 0; x < rect.width; x++) {
+      row[x] = iterate_point(step_coord(x_fixed, inc_fixed, rect.x + x), y_pos, max_iterations);
+    }
+  }
+}
+
+void drawMandelbrotRect(fixed_32 x_fixed, fixed_32 y_fixed, fixed_32 inc_fixed, int max_iterations, const pixel_rect& rect, colour* out, size_t stride, const std::vector<colour>& colour_map) {
+  for (int y = 0; y < rect.height; y++) {
+    colour* row = out + y * stride;
+    fixed_32 y_pos = step_coord(y_fixed, inc_fixed, -(rect.y + y));
+    for (int x = 0; x < rect.width; x++) {
+      row[x] = iteration_colour(iterate_point(step_coord(x_fixed, inc_fixed, rect.x + x), y_pos, max_iterations), max_iterations, colour_map);
+    }
+  }
+}
+
+// split one frame across threads; rows are interleaved so expensive bands are shared out evenly
+void iterateMandelbrotParallel(fixed_32 x_fixed, fixed_32 y_fixed, fixed_32 inc_fixed, int max_iterations, uint16_t* iteration_buffer, int width, int height, size_t stride, int threads) {
+  if (threads <= 1) {
+    iterateMandelbrotRows(x_fixed, y_fixed, inc_fixed, max_iterations, iteration_buffer, width, height, stride, 0, 1);
+    return;
+  }
+  std::vector<std::thread> workers;
+  for (int t = 0; t < threads; t++) {
+    workers.emplace_back(iterateMandelbrotRows, x_fixed, y_fixed, inc_fixed, max_iterations, iteration_buffer, width, height, stride, t, threads);
+  }
+  for (std::thread& worker : workers) {
+    worker.join();
+  }
+}
+
+int mirror_row_sum(const coord_step& c, int height) {
+  // y(r) = c.y - r * step, so y(r) + y(k - r) = 0 needs 2 * c.y = k * step
+  int64_t twice = 2 * int64_t(c.y);
+  if (c.step == 0 || twice % c.step != 0) {
+    return -1;
+  }
+  // frames that wrap past -4 are not symmetric
+  if (int64_t(c.y) - int64_t(height - 1) * c.step < INT32_MIN) {
+    return -1;
+  }
+  int64_t sum = twice / c.step;
+  // at least one pair of distinct rows inside the frame
+  return sum >= 1 && sum <= 2 * int64_t(height) - 3 ? int(sum) : -1;
+}
+
+static void iterateMirroredRows(fixed_32 x_fixed, fixed_32 y_fixed, fixed_32 inc_fixed, int max_iterations, uint16_t* iteration_buffer, int width, int height, size_t stride, int mirror_sum, int first_row, int row_step) {
+  for (int y = first_row; y < height; y += row_step) {
+    int pair = mirror_sum - y;
+    // the pair row is filled by whichever of the two comes first
+    if (pair >= 0 && pair < y) {
+      continue;
+    }
+    uint16_t* row = iteration_buffer + y * stride;
+    fixed_32 y_pos = step_coord(y_fixed, inc_fixed, -y);
+    fixed_32 x_pos = x_fixed;
+    if (pair <= y || pair >= height) {
+      for (int x = 0; x < width; x++) {
+        row[x] = iterate_point(x_pos, y_pos, max_iterations);
+        x_pos = step_coord(x_pos, inc_fixed, 1);
+      }
+      continue;
+    }
+    uint16_t* mirror_row = iteration_buffer + pair * stride;
+    fixed_32 mirror_y = step_coord(y_fixed, inc_fixed, -pair);
+    for (int x = 0; x < width; x++) {
+      int mirror;
+      row[x] = iterate_point_pair(x_pos, y_pos, mirror_y, max_iterations, &mirror);
+      mirror_row[x] = mirror;
+      x_pos = step_coord(x_pos, inc_fixed, 1);
+    }
+  }
+}
+
+void iterateMandelbrotMirrored(fixed_32 x_fixed, fixed_32 y_fixed, fixed_32 inc_fixed, int max_iterations, uint16_t* iteration_buffer, int width, int height, size_t stride, int threads) {
+  coord_step c = {x_fixed, y_fixed, inc_fixed};
+  int mirror_sum = mirror_row_sum(c, height);
+  if (mirror_sum < 0) {
+    iterateMandelbrotParallel(x_fixed, y_fixed, inc_fixed, max_iterations, iteration_buffer, width, height, stride, threads);
+    return;
+  }
+  if (threads <= 1) {
+    iterateMirroredRows(x_fixed, y_fixed, inc_fixed, max_iterations, iteration_buffer, width, height, stride, mirror_sum, 0, 1);
+    return;
+  }
+  std::vector<std::thread> workers;
+  for (int t = 0; t < threads; t++) {
+    workers.emplace_back(iterateMirroredRows, x_fixed, y_fixed, inc_fixed, max_iterations, iteration_buffer, width, height, stride, mirror_sum, t, threads);
+  }
+  for (std::thread& worker : workers) {
+    worker.join();
+  }
+}
+
+void colouriseMandelbrot(const uint16_t* iteration_buffer, size_t iteration_stride, colour* framebuffer, size_t framebuffer_stride, int width, int height, int max_iterations, const std::vector<colour>& colour_map) {
+  for (int y = 0; y < height; y++) {
+    const uint16_t* in = iteration_buffer + y * iteration_stride;
+    colour* out = framebuffer + y * framebuffer_stride;
+    for (int x = 0; x < width; x++) {
+      out[x] = iteration_colour(in[x], max_iterations, colour_map);
+    }
+  }
+}
+
+void write_ppm_file(const std::string& filename, const colour* framebuffer, int width, int height, size_t stride)
+{
+  std::ofstream ofs;
+  ofs.open(filename, std::ios::out | std::ios::binary);
+  ofs << "P6\n" << width << " " << height << "\n255\n";
+  for (int y = 0; y < height; y++) {
+    const colour* row = framebuffer + y * stride;
+    for (int x = 0; x < width; x++) {
+      uint8_t r = RED(row[x]) << 3;
+      uint8_t g = GREEN(row[x]) << 2;
+      uint8_t b = BLUE(row[x]) << 3;
+      ofs << r << g << b;
+    }
+  }
+  ofs.close();
+}
+
+void write_framebuffer_file(const std::string& filename, const colour* framebuffer, int width, int height, size_t stride)
+{
+    std::ofstream ofs(filename);
+    if (!ofs.is_open()) {
+        return;
+    }
+
+    for (int y = 0; y < height; y++) {
+        const colour* row = framebuffer + y * stride;
+        for (int x = 0; x < width; x++) {
+            ofs << x << " " << y << " 0x" 
+                << std::hex << std::setw(4) << std::setfill('0') << row[x] 
+                << std::dec << "\n";
+        }
+    }
+}
+
+Renderer::Renderer(int width, int height) {
+  if (!resize(width, height)) {
+    resize(DEFAULT_XSIZE, DEFAULT_YSIZE);
+  }
+}
+
+bool Renderer::resize(int width, int height) {
+  if (width < 1 || height < 1 || width > MAX_XSIZE || height > MAX_YSIZE) {
+    return false;
+  }
+  const size_t row_align = BUFFER_ALIGNMENT / sizeof(uint16_t);
+  size_t stride = (size_t(width) + row_align - 1) & ~(row_align - 1);
+  if (!iterations_.reserve(stride * height) || !framebuffer_.reserve(stride * height)) {
+    return false;
+  }
+  // every allocation that can fail is made before anything changes
+  tile_layout tiles;
+  if (layout_ == LAYOUT_TILED && !reserve_tiles(tiles, width, height)) {
+    return false;
+  }
+  width_ = width;
+  height_ = height;
+  stride_ = stride;
+  if (layout_ == LAYOUT_TILED) {
+    use_tiles(std::move(tiles));
+  }
+  return true;
+}
+
+bool Renderer::set_layout(buffer_layout layout) {
+  if (layout == LAYOUT_TILED) {
+    tile_layout tiles;
+    if (!reserve_tiles(tiles, width_, height_)) {
+      return false;
+    }
+    use_tiles(std::move(tiles));
+  }
+  layout_ = layout;
+  return true;
+}
+
+bool Renderer::reserve_tiles(tile_layout& tiles, int width, int height) {
+  build_tile_layout(tiles, width, height);
+  return iterations_.reserve(tiled_size(tiles)) && tiled_colours_.reserve(tiled_size(tiles));
+}
+
+void Renderer::use_tiles(tile_layout tiles) {
+  // edge tiles are only partly written, keep the rest defined for colourise
+  std::fill(iterations_.data(), iterations_.data() + tiled_size(tiles), 0);
+  tiles_ = std::move(tiles);
+}
+
+coord_step Renderer::view(fixed_32 center_x, fixed_32 center_y, int zoom) const {
+  return center_coords(center_x, center_y, zoom, width_, height_);
+}
+
+void Renderer::build_colour_map(const colour interp_points[6], int max_iterations) {
+  FRAME_STATS(auto start = std::chrono::steady_clock::now();)
+  std::vector<colour> unique_colours = {};
+  std::vector<colour> points(interp_points, interp_points + 6);
+  colour_map_.clear();
+  generate_unique_colours(unique_colours, points);
+  generate_colour_map(max_iterations, unique_colours, colour_map_);
+  max_iterations_ = max_iterations;
+  FRAME_STATS(stats_.colour_map_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();)
+}
+
+void Renderer::iterate(const coord_step& c, int max_iterations, int threads) {
+#ifdef MANDELBROT_STATS
+  iterate_timed(c, max_iterations, threads);
+#else
+  if (layout_ == LAYOUT_TILED) {
+    iterateMandelbrotTilesParallel(c.x, c.y, c.step, max_iterations, iterations_.data(), tiles_, threads);
+  }
+  else if (mirror_) {
+    iterateMandelbrotMirrored(c.x, c.y, c.step, max_iterations, iterations_.data(), width_, height_, stride_, threads);
+  }
+  else {
+    iterateMandelbrotParallel(c.x, c.y, c.step, max_iterations, iterations_.data(), width_, height_, stride_, threads);
+  }
+#endif
+}
+
+#ifdef MANDELBROT_STATS
+// Same work as iterate, but one row (or tile) per kernel call so each can be timed. Rows and
+// tiles are dealt out to threads in turn rather than claimed, which is close enough for stats.
+// With mirror_ the first row of each mirrored pair is charged for both rows and the second for next to nothing.
+void Renderer::iterate_timed(const coord_step& c, int max_iterations, int threads) {
+  auto start = std::chrono::steady_clock::now();
+  bool tiled = layout_ == LAYOUT_TILED;
+  int mirror_sum = mirror_ && !tiled ? mirror_row_sum(c, height_) : -1;
+  int units = tiled ? tiles_.tiles_x * tiles_.tiles_y : height_;
+  stats_.row_us.assign(tiled ? 0 : height_, 0.0f);
+  stats_.tile_us.assign(tiled ? units : 0, 0.0f);
+  auto work = [&](int first) {
+    for (int u = first; u < units; u += std::max(1, threads)) {
+      auto unit_start = std::chrono::steady_clock::now();
+      if (tiled) {
+        iterateMandelbrotTiles(c.x, c.y, c.step, max_iterations, iterations_.data(), tiles_, u, units);
+      }
+      else if (mirror_sum >= 0) {
+        iterateMirroredRows(c.x, c.y, c.step, max_iterations, iterations_.data(), width_, height_, stride_, mirror_sum, u, height_);
+      }
+      else {
+        iterateMandelbrotRows(c.x, c.y, c.step, max_iterations, iterations_.data(), width_, height_, stride_, u, height_);
+      }
+      float us = std::chrono::duration<float, std::micro>(std::chrono::steady_clock::now() - unit_start).count();
+      if (tiled) {
+        uint32_t tile = tiles_.tile_of_slot[u];
+        stats_.tile_us[(tile >> 16) * tiles_.tiles_x + (tile & 0xffff)] = us;
+      }
+      else {
+        stats_.row_us[u] = us;
+      }
+    }
+  };
+  if (threads <= 1) {
+    work(0);
+  }
+  else {
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+      workers.emplace_back(work, t);
+    }
+    for (std::thread& worker : workers) {
+      worker.join();
+    }
+  }
+  stats_.iterate_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+  collect_stats(max_iterations);
+}
+
+void Renderer::collect_stats(int max_iterations) {
+  stats_.width = width_;
+  stats_.height = height_;
+  stats_.max_iterations = max_iterations;
+  stats_.total_iterations = 0;
+  stats_.escaped = 0;
+  stats_.capped = 0;
+  std::fill(stats_.histogram, stats_.histogram + STATS_HISTOGRAM_BINS, 0);
+  for (int y = 0; y < height_; y++) {
+    for (int x = 0; x < width_; x++) {
+      int count = iteration_at(x, y);
+      stats_.total_iterations += count;
+      if (count >= max_iterations) {
+        stats_.capped++;
+      }
+      else {
+        stats_.escaped++;
+      }
+      stats_.histogram[size_t(count) * STATS_HISTOGRAM_BINS / (max_iterations + 1)]++;
+    }
+  }
+}
+#endif
+
+void Renderer::colourise() {
+  colourise(framebuffer_.data(), stride_);
+}
+
+void Renderer::colourise(colour* framebuffer, size_t framebuffer_stride) {
+  if (layout_ == LAYOUT_TILED) {
+    // colour lookup does not care about pixel order, so colour the tiles as one long row then de-tile
+    int tiled_pixels = tiled_size(tiles_);
+    colouriseMandelbrot(iterations_.data(), tiled_pixels, tiled_colours_.data(), tiled_pixels, tiled_pixels, 1, max_iterations_, colour_map_);
+    detile(tiles_, tiled_colours_.data(), framebuffer, framebuffer_stride);
+  }
+  else {
+    colouriseMandelbrot(iterations_.data(), stride_, framebuffer, framebuffer_stride, width_, height_, max_iterations_, colour_map_);
+  }
+}
+
+void Renderer::clear(colour value) {
+  std::fill(framebuffer_.data(), framebuffer_.data() + stride_ * height_, value);
+}
@@ -0,0 +1,192 @@
+/* ----------------------------------------------------------
+**
+**
+**   Algorithmic level model of Drawing engine - renderer library
+**
+**   Drawing engine module: Mandelbrot: fixed point Q3.29
+**
+**   Luke Rule
+**
+---------------------------------------------------------- */
+#ifndef MANDELBROT_RENDERER_H
+#define MANDELBROT_RENDERER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <vector>
+#include <string>
+
+#include "mandelbrot_fixed.h"
+#include "tile_layout.h"
+#include "frame_stats.h"
+
+// Resolution of the display the testbench checks against
+#define DEFAULT_XSIZE 640
+#define DEFAULT_YSIZE 480
+// Largest resolution a Renderer accepts (4K UHD)
+#define MAX_XSIZE 3840
+#define MAX_YSIZE 2160
+// Buffers and rows are aligned to a cache line
+#define BUFFER_ALIGNMENT 64
+
+int get_spread_colour_index(int iterations, int max_iterations);
+void generate_unique_colours(std::vector<colour>& unique_colours, std::vector<colour>& interp_points);
+void generate_colour_map(int max_iterations, std::vector<colour>& unique_colours, std::vector<colour>& colour_map);
+// get colour from colour map based on iterations
+colour iteration_colour(int iterations, int max_iterations, const std::vector<colour>& colour_map);
+
+// calculate the top-left coordinates and step size based on center coords and zoom level
+coord_step center_coords(fixed_32 center_x, fixed_32 center_y, int zoom, int width = DEFAULT_XSIZE, int height = DEFAULT_YSIZE);
+
+// a sub-rectangle of the frame, in pixels
+struct pixel_rect {
+  int x;
+  int y;
+  int width;
+  int height;
+};
+
+// Frame level functions. Buffers are row-major with stride elements between rows.
+void drawMandelbrot(fixed_32 x_fixed, fixed_32 y_fixed, fixed_32 inc_fixed, int max_iterations, colour* framebuffer, int width, int height, size_t stride, const std::vector<colour>& colour_map);
+// iteration counts only, for every row_step'th row starting at first_row so threads can share a frame
+void iterateMandelbrotRows(fixed_32 x_fixed, fixed_32 y_fixed, fixed_32 inc_fixed, int max_iterations, uint16_t* iteration_buffer, int width, int height, size_t stride, int first_row, int row_step);
+void iterateMandelbrotParallel(fixed_32 x_fixed, fixed_32 y_fixed, fixed_32 inc_fixed, int max_iterations, uint16_t* iteration_buffer, int width, int height, size_t stride, int threads);
+// Conjugate-symmetry mirroring for views straddling the real axis: row r and row mirror - r have
+// opposite y. mirror_row_sum gives that sum, or -1 if no two rows of the frame are mirror images.
+int mirror_row_sum(const coord_step& c, int height);
+// Same iteration counts as iterateMandelbrotParallel, bit for bit. fixed_mult floors, so -y does
+// not always mirror z exactly and whole rows cannot be copied. iterate_point_pair copies a pixel's
+// count to its mirror image where the orbit proves them equal, and otherwise finishes the two in
+// lockstep from the first step where they part.
+void iterateMandelbrotMirrored(fixed_32 x_fixed, fixed_32 y_fixed, fixed_32 inc_fixed, int max_iterations, uint16_t* iteration_buffer, int width, int height, size_t stride, int threads);
+// Region of interest: only the pixels of rect, for the frame whose top-left point is (x_fixed, y_fixed).
+// Every pixel gets exactly the c it has in a full render. out points at the rect's top-left pixel,
+// so either a rect-sized buffer or the matching position in a full framebuffer can be passed.
+void drawMandelbrotRect(fixed_32 x_fixed, fixed_32 y_fixed, fixed_32 inc_fixed, int max_iterations, const pixel_rect& rect, colour* out, size_t stride, const std::vector<colour>& colour_map);
+void iterateMandelbrotRect(fixed_32 x_fixed, fixed_32 y_fixed, fixed_32 inc_fixed, int max_iterations, const pixel_rect& rect, uint16_t* out, size_t stride);
+// map an iteration buffer through the colour map, giving the same frame as drawMandelbrot
+void colouriseMandelbrot(const uint16_t* iteration_buffer, size_t iteration_stride, colour* framebuffer, size_t framebuffer_stride, int width, int height, int max_iterations, const std::vector<colour>& colour_map);
+
+// debug function to write image file in PPM format
+void write_ppm_file(const std::string& filename, const colour* framebuffer, int width, int height, size_t stride);
+// function to write framebuffer values to text file for test comparison
+void write_framebuffer_file(const std::string& filename, const colour* framebuffer, int width, int height, size_t stride);
+
+// Heap buffer aligned to BUFFER_ALIGNMENT that only reallocates when it has to grow
+template <typename T>
+class aligned_buffer {
+public:
+  aligned_buffer() = default;
+  aligned_buffer(const aligned_buffer&) = delete;
+  aligned_buffer& operator=(const aligned_buffer&) = delete;
+  ~aligned_buffer() { free(data_); }
+
+  bool reserve(size_t count) {
+    if (count <= capacity_) {
+      return true;
+    }
+    size_t bytes = (count * sizeof(T) + BUFFER_ALIGNMENT - 1) & ~size_t(BUFFER_ALIGNMENT - 1);
+    T* data = static_cast<T*>(aligned_alloc(BUFFER_ALIGNMENT, bytes));
+    if (data == nullptr) {
+      return false;
+    }
+    free(data_);
+    data_ = data;
+    capacity_ = count;
+    return true;
+  }
+  T* data() { return data_; }
+  const T* data() const { return data_; }
+
+private:
+  T* data_ = nullptr;
+  size_t capacity_ = 0;
+};
+
+// internal layout of the iteration buffer
+enum buffer_layout {
+  LAYOUT_ROW_MAJOR,
+  LAYOUT_TILED        // TILE_SIZE tiles in Morton order, see tile_layout.h
+};
+
+// Reusable renderer for embedding the model. Owns the iteration buffer, the colour framebuffer
+// and the colour map, so rendering many frames allocates nothing after the first one at the
+// largest resolution. The three stages can be run separately, e.g. to re-colour one iteration
+// buffer with several palettes. With LAYOUT_TILED the iteration buffer is kept in tiles and only
+// de-tiled when colour output is produced; the framebuffer is always row-major.
+class Renderer {
+public:
+  Renderer(int width = DEFAULT_XSIZE, int height = DEFAULT_YSIZE);
+
+  // change resolution; false (and unchanged) if outside 1x1 to MAX_XSIZE x MAX_YSIZE
+  bool resize(int width, int height);
+  int width() const { return width_; }
+  int height() const { return height_; }
+  // elements between rows of both buffers, rounded up so every row is cache line aligned
+  size_t stride() const { return stride_; }
+
+  // switch the iteration buffer layout, the buffer contents are not converted
+  bool set_layout(buffer_layout layout);
+  buffer_layout layout() const { return layout_; }
+  const tile_layout& tiles() const { return tiles_; }
+  // iterate row-major views that straddle the real axis with iterateMandelbrotMirrored
+  void set_mirror(bool mirror) { mirror_ = mirror; }
+  bool mirror() const { return mirror_; }
+
+  // top-left point and step of a view at this resolution
+  coord_step view(fixed_32 center_x, fixed_32 center_y, int zoom) const;
+
+  // colour-map build from the 6 interpolation points, for max_iterations entries
+  void build_colour_map(const colour interp_points[6], int max_iterations);
+  // iterate the view into the iteration buffer, on threads threads
+  void iterate(const coord_step& c, int max_iterations, int threads = 1);
+  // colourise the iteration buffer with the current colour map into the framebuffer
+  void colourise();
+  // colourise into caller memory instead, e.g. a shared-memory ring slot
+  void colourise(colour* framebuffer, size_t framebuffer_stride);
+  // fill the framebuffer with one colour, e.g. grey to show unwritten pixels
+  void clear(colour value);
+
+  uint16_t* iterations() { return iterations_.data(); }
+  const uint16_t* iterations() const { return iterations_.data(); }
+  colour* framebuffer() { return framebuffer_.data(); }
+  const colour* framebuffer() const { return framebuffer_.data(); }
+  // position of a pixel in the iteration buffer whatever the layout
+  size_t iteration_offset(int x, int y) const {
+    return layout_ == LAYOUT_TILED ? tiled_offset(tiles_, x, y) : y * stride_ + x;
+  }
+  uint16_t iteration_at(int x, int y) const { return iterations_.data()[iteration_offset(x, y)]; }
+  const std::vector<colour>& colour_map() const { return colour_map_; }
+  // iteration limit the current colour map was built for
+  int max_iterations() const { return max_iterations_; }
+#ifdef MANDELBROT_STATS
+  // counts and timings of the last iterate, plus the last colour-map build time
+  const frame_stats& stats() const { return stats_; }
+#endif
+
+private:
+  // build the tile layout for a size and make room for it, without switching to it
+  bool reserve_tiles(tile_layout& tiles, int width, int height);
+  void use_tiles(tile_layout tiles);
+
+  int width_ = 0;
+  int height_ = 0;
+  size_t stride_ = 0;
+  int max_iterations_ = 1;
+  buffer_layout layout_ = LAYOUT_ROW_MAJOR;
+  bool mirror_ = false;
+  tile_layout tiles_;
+  aligned_buffer<uint16_t> iterations_;
+  aligned_buffer<colour> framebuffer_;
+  // colour output before de-tiling, only used with LAYOUT_TILED
+  aligned_buffer<colour> tiled_colours_;
+  std::vector<colour> colour_map_;
+#ifdef MANDELBROT_STATS
+  frame_stats stats_;
+  void iterate_timed(const coord_step& c, int max_iterations, int threads);
+  void collect_stats(int max_iterations);
+#endif
+};
+
+#endif
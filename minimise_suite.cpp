@@ -0,0 +1,157 @@
+/* ----------------------------------------------------------
+**
+**
+**   Coverage-driven regression suite minimisation
+**
+**   Renders every candidate case with the model, records the
+**   coverage features of suite_coverage.h and writes the
+**   cheapest subset (in RTL cycles) that covers every feature
+**   the candidates cover, in input order.
+**
+**   usage: minimise_suite [--input file] [--output file]
+**                         [--binary] [--size WxH] [--threads N]
+**                         [--report]
+**
+**   Luke Rule
+**
+---------------------------------------------------------- */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+
+#include "mandelbrot_renderer.h"
+#include "batch_render.h"
+#include "suite_coverage.h"
+
+// the case as it was written, untrapped
+static batch_record to_record(const test_case& t) {
+  batch_record r;
+  r.center_x = uint32_t(t.center_x);
+  r.center_y = uint32_t(t.center_y);
+  r.zoom = t.zoom;
+  r.max_iterations = t.requested_max_iterations;
+  std::copy(t.colours, t.colours + 6, r.colours);
+  r.ack_mode = t.ack_mode;
+  return r;
+}
+
+static bool write_suite(const std::string& filename, const std::vector<test_case>& cases, const std::vector<int>& chosen, bool binary) {
+  FILE* file = fopen(filename.c_str(), binary ? "wb" : "w");
+  if (file == nullptr) {
+    return false;
+  }
+  if (binary) {
+    uint32_t magic = BATCH_FILE_MAGIC;
+    fwrite(&magic, sizeof(magic), 1, file);
+  }
+  for (size_t i = 0; i < chosen.size(); i++) {
+    batch_record r = to_record(cases[chosen[i]]);
+    if (binary) {
+      fwrite(&r, sizeof(r), 1, file);
+    }
+    else {
+      // no newline after the last line, for the testbench's $feof loop
+      fprintf(file, "%s0x%08x 0x%08x %d %d 0x%04x 0x%04x 0x%04x 0x%04x 0x%04x 0x%04x %d", i == 0 ? "" : "\n", r.center_x, r.center_y, r.zoom,
+              r.max_iterations, r.colours[0], r.colours[1], r.colours[2], r.colours[3], r.colours[4], r.colours[5], r.ack_mode);
+    }
+  }
+  bool ok = !ferror(file);
+  return fclose(file) == 0 && ok;
+}
+
+int main(int argc, char** argv)
+{
+  std::string input_file = "/home/p74644lr/Questa/COMP32211/src/Phase_2/input_file.txt";
+  std::string output;
+  bool binary = false;
+  bool report = false;
+  int width = DEFAULT_XSIZE;
+  int height = DEFAULT_YSIZE;
+  int threads = std::max(1u, std::thread::hardware_concurrency());
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--input") == 0 && i + 1 < argc) {
+      input_file = argv[++i];
+    }
+    else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+      output = argv[++i];
+    }
+    else if (strcmp(argv[i], "--binary") == 0) {
+      binary = true;
+    }
+    else if (strcmp(argv[i], "--report") == 0) {
+      report = true;
+    }
+    else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+      threads = std::max(1, atoi(argv[++i]));
+    }
+    else if (strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+      if (sscanf(argv[++i], "%dx%d", &width, &height) != 2 || width < 1 || height < 1 || width > MAX_XSIZE || height > MAX_YSIZE) {
+        fprintf(stderr, "bad size\n");
+        return 1;
+      }
+    }
+  }
+
+  std::vector<test_case> cases = read_test_cases(input_file);
+  if (cases.empty()) {
+    fprintf(stderr, "no cases in %s\n", input_file.c_str());
+    return 1;
+  }
+  auto start = std::chrono::steady_clock::now();
+  std::vector<case_coverage> coverage = measure_coverage(cases, width, height, threads);
+  std::vector<int> chosen = minimise_suite(coverage);
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  coverage_set covered;
+  uint64_t all_cycles = 0;
+  for (const case_coverage& c : coverage) {
+    covered |= c.features;
+    all_cycles += c.hardware_cycles;
+  }
+  uint64_t chosen_cycles = 0;
+  for (int i : chosen) {
+    chosen_cycles += coverage[i].hardware_cycles;
+  }
+  printf("%zu candidates measured in %.2f s, %zu of %d features covered\n", cases.size(), seconds, covered.count(), COVER_FEATURE_COUNT);
+  printf("kept %zu cases: %.1f M of %.1f M RTL cycles (%.1f%%)\n", chosen.size(), chosen_cycles / 1e6, all_cycles / 1e6,
+         100.0 * chosen_cycles / all_cycles);
+  if (covered.count() < COVER_FEATURE_COUNT) {
+    printf("never covered:");
+    for (int f = 0; f < COVER_FEATURE_COUNT; f++) {
+      if (!covered[f]) {
+        printf(" %s", coverage_feature_name(f).c_str());
+      }
+    }
+    printf("\n");
+  }
+  if (report) {
+    // each kept case with the features no other kept case has
+    printf("\n");
+    for (int i : chosen) {
+      coverage_set others;
+      for (int j : chosen) {
+        if (j != i) {
+          others |= coverage[j].features;
+        }
+      }
+      printf("case %d (%.2f M cycles): only", i, coverage[i].hardware_cycles / 1e6);
+      coverage_set unique = coverage[i].features & ~others;
+      for (int f = 0; f < COVER_FEATURE_COUNT; f++) {
+        if (unique[f]) {
+          printf(" %s", coverage_feature_name(f).c_str());
+        }
+      }
+      printf("\n");
+    }
+  }
+  if (!output.empty() && !write_suite(output, cases, chosen, binary)) {
+    fprintf(stderr, "could not write %s\n", output.c_str());
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,125 @@
+/* ----------------------------------------------------------
+**
+**
+**   Conjugate-symmetry mirroring audit
+**
+**   For every distinct view of an input file whose rows pair
+**   up across the real axis, renders it directly and with
+**   iterateMandelbrotMirrored, checks the two agree on every
+**   pixel, and reports how many pixels copying mirrored rows
+**   would get wrong and whether checking a few sampled row
+**   pairs would have noticed.
+**
+**   usage: mirror_audit [--input file] [--size WxH]
+**                       [--threads N] [--sample N]
+**
+**   Luke Rule
+**
+---------------------------------------------------------- */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+
+#include "mandelbrot_renderer.h"
+#include "batch_render.h"
+
+int main(int argc, char** argv)
+{
+  std::string input_file = "/home/p74644lr/Questa/COMP32211/src/Phase_2/input_file.txt";
+  int width = DEFAULT_XSIZE;
+  int height = DEFAULT_YSIZE;
+  int threads = std::max(1u, std::thread::hardware_concurrency());
+  int sample = 16;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--input") == 0 && i + 1 < argc) {
+      input_file = argv[++i];
+    }
+    else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+      threads = std::max(1, atoi(argv[++i]));
+    }
+    else if (strcmp(argv[i], "--sample") == 0 && i + 1 < argc) {
+      sample = std::max(1, atoi(argv[++i]));
+    }
+    else if (strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+      if (sscanf(argv[++i], "%dx%d", &width, &height) != 2 || width < 1 || height < 1 || width > MAX_XSIZE || height > MAX_YSIZE) {
+        fprintf(stderr, "bad size\n");
+        return 1;
+      }
+    }
+  }
+
+  std::vector<test_case> cases = read_test_cases(input_file);
+  if (cases.empty()) {
+    fprintf(stderr, "no cases in %s\n", input_file.c_str());
+    return 1;
+  }
+  std::vector<geometry_group> groups = plan_geometry_groups(cases, true, width, height);
+  std::vector<uint16_t> direct(size_t(width) * height);
+  std::vector<uint16_t> mirrored(size_t(width) * height);
+  double direct_total = 0.0;
+  double mirrored_total = 0.0;
+  uint64_t wrong = 0;
+
+  printf("%-6s %6s %5s %9s %10s %8s %9s %9s %7s\n", "case", "iters", "pairs", "bad pairs", "bad pixels", "sample", "direct", "mirrored", "speedup");
+  for (const geometry_group& g : groups) {
+    int mirror_sum = mirror_row_sum(g.c, height);
+    if (mirror_sum < 0) {
+      continue;
+    }
+    auto start = std::chrono::steady_clock::now();
+    iterateMandelbrotParallel(g.c.x, g.c.y, g.c.step, g.max_iterations, direct.data(), width, height, width, threads);
+    auto middle = std::chrono::steady_clock::now();
+    iterateMandelbrotMirrored(g.c.x, g.c.y, g.c.step, g.max_iterations, mirrored.data(), width, height, width, threads);
+    auto end = std::chrono::steady_clock::now();
+    double direct_ms = std::chrono::duration<double, std::milli>(middle - start).count();
+    double mirrored_ms = std::chrono::duration<double, std::milli>(end - middle).count();
+    direct_total += direct_ms;
+    mirrored_total += mirrored_ms;
+
+    uint64_t differ = 0;
+    for (size_t i = 0; i < direct.size(); i++) {
+      differ += direct[i] != mirrored[i];
+    }
+    wrong += differ;
+    // what copying whole rows would get wrong, and whether evenly spaced sample pairs show it
+    std::vector<int> bad_pairs;
+    int pairs = 0;
+    uint64_t copy_errors = 0;
+    for (int y = 0; y < height; y++) {
+      int pair = mirror_sum - y;
+      if (pair <= y || pair >= height) {
+        continue;
+      }
+      pairs++;
+      int errors = 0;
+      for (int x = 0; x < width; x++) {
+        errors += direct[size_t(y) * width + x] != direct[size_t(pair) * width + x];
+      }
+      if (errors != 0) {
+        bad_pairs.push_back(pairs - 1);
+      }
+      copy_errors += errors;
+    }
+    bool sample_caught = false;
+    for (int s = 0; s < std::min(sample, pairs); s++) {
+      int pair_index = int(int64_t(s) * pairs / std::min(sample, pairs));
+      sample_caught = sample_caught || std::binary_search(bad_pairs.begin(), bad_pairs.end(), pair_index);
+    }
+    std::string verdict = copy_errors == 0 ? "-" : sample_caught ? "caught" : "missed";
+    printf("%-6d %6d %5d %9zu %10llu %8s %7.1fms %7.1fms %6.2fx%s\n", cases[g.cases[0]].file_count, g.max_iterations, pairs, bad_pairs.size(),
+           (unsigned long long)copy_errors, verdict.c_str(), direct_ms, mirrored_ms, direct_ms / mirrored_ms, differ != 0 ? "  MISMATCH" : "");
+  }
+  if (direct_total > 0.0) {
+    printf("mirrored views: %.1f ms direct, %.1f ms mirrored (%.2fx)\n", direct_total, mirrored_total, direct_total / mirrored_total);
+  }
+  if (wrong != 0) {
+    printf("%llu pixels differ from the direct render\n", (unsigned long long)wrong);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,154 @@
+/* ----------------------------------------------------------
+**
+**
+**   Hardware performance counters (Linux perf_event_open)
+**
+**   Luke Rule
+**
+---------------------------------------------------------- */
+#include "perf_counters.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <chrono>
+
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+void perf_sample::add(const perf_sample& other) {
+  seconds += other.seconds;
+  for (int i = 0; i < PERF_COUNTER_COUNT; i++) {
+    value[i] += other.value[i];
+    valid[i] = valid[i] && other.valid[i];
+  }
+}
+
+#ifdef __linux__
+static const uint64_t perf_configs[PERF_COUNTER_COUNT] = {
+  PERF_COUNT_HW_CPU_CYCLES,
+  PERF_COUNT_HW_INSTRUCTIONS,
+  PERF_COUNT_HW_BRANCH_MISSES,
+  PERF_COUNT_HW_CACHE_MISSES,
+};
+
+static int open_counter(uint64_t config) {
+  struct perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = PERF_TYPE_HARDWARE;
+  attr.config = config;
+  attr.disabled = 1;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  // follow threads started while counting, e.g. the frame threads of iterateMandelbrotParallel
+  attr.inherit = 1;
+  // with more events than hardware counters the kernel multiplexes, these let us scale back up
+  attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+  return int(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+}
+#endif
+
+perf_counters::perf_counters() {
+  for (int i = 0; i < PERF_COUNTER_COUNT; i++) {
+    fd_[i] = -1;
+  }
+#ifdef __linux__
+  for (int i = 0; i < PERF_COUNTER_COUNT; i++) {
+    fd_[i] = open_counter(perf_configs[i]);
+    if (fd_[i] < 0 && reason_.empty()) {
+      reason_ = std::string("perf_event_open: ") + strerror(errno);
+      if (errno == EACCES || errno == EPERM) {
+        reason_ += " (see /proc/sys/kernel/perf_event_paranoid)";
+      }
+    }
+  }
+#else
+  reason_ = "hardware counters are only supported on Linux";
+#endif
+}
+
+perf_counters::~perf_counters() {
+#ifdef __linux__
+  for (int i = 0; i < PERF_COUNTER_COUNT; i++) {
+    if (fd_[i] >= 0) {
+      close(fd_[i]);
+    }
+  }
+#endif
+}
+
+bool perf_counters::available() const {
+  for (int i = 0; i < PERF_COUNTER_COUNT; i++) {
+    if (fd_[i] >= 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static int64_t now_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void perf_counters::start() {
+#ifdef __linux__
+  for (int i = 0; i < PERF_COUNTER_COUNT; i++) {
+    if (fd_[i] >= 0) {
+      ioctl(fd_[i], PERF_EVENT_IOC_RESET, 0);
+      ioctl(fd_[i], PERF_EVENT_IOC_ENABLE, 0);
+    }
+  }
+#endif
+  start_ns_ = now_ns();
+}
+
+perf_sample perf_counters::stop() {
+  perf_sample sample;
+  int64_t end_ns = now_ns();
+#ifdef __linux__
+  for (int i = 0; i < PERF_COUNTER_COUNT; i++) {
+    if (fd_[i] < 0) {
+      continue;
+    }
+    ioctl(fd_[i], PERF_EVENT_IOC_DISABLE, 0);
+    uint64_t data[3];   // value, time enabled, time running
+    if (read(fd_[i], data, sizeof(data)) == ssize_t(sizeof(data)) && data[2] > 0) {
+      sample.value[i] = data[2] < data[1] ? uint64_t(double(data[0]) * data[1] / data[2]) : data[0];
+      sample.valid[i] = true;
+    }
+  }
+#endif
+  sample.seconds = (end_ns - start_ns_) / 1e9;
+  return sample;
+}
+
+std::string perf_sample_header() {
+  char row[128];
+  snprintf(row, sizeof(row), "%10s %14s %14s %6s %12s %12s", "ms", "cycles", "instructions", "IPC", "br-misses", "cache-misses");
+  return row;
+}
+
+std::string perf_sample_row(const perf_sample& sample) {
+  char row[160];
+  char fields[PERF_COUNTER_COUNT][24];
+  for (int i = 0; i < PERF_COUNTER_COUNT; i++) {
+    if (sample.valid[i]) {
+      snprintf(fields[i], sizeof(fields[i]), "%llu", (unsigned long long)sample.value[i]);
+    }
+    else {
+      snprintf(fields[i], sizeof(fields[i]), "-");
+    }
+  }
+  char ipc[16] = "-";
+  if (sample.valid[PERF_CYCLES] && sample.valid[PERF_INSTRUCTIONS]) {
+    snprintf(ipc, sizeof(ipc), "%.2f", sample.ipc());
+  }
+  snprintf(row, sizeof(row), "%10.3f %14s %14s %6s %12s %12s", sample.seconds * 1e3,
+           fields[PERF_CYCLES], fields[PERF_INSTRUCTIONS], ipc, fields[PERF_BRANCH_MISSES], fields[PERF_CACHE_MISSES]);
+  return row;
+}
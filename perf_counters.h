@@ -0,0 +1,65 @@
+/* ----------------------------------------------------------
+**
+**
+**   Hardware performance counters (Linux perf_event_open)
+**
+**   Counts the calling thread and any threads it starts while
+**   counting. Where counters are not permitted (containers,
+**   perf_event_paranoid, other OSes) only wall time is kept.
+**
+**   Luke Rule
+**
+---------------------------------------------------------- */
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <stdint.h>
+#include <string>
+
+enum perf_counter_id {
+  PERF_CYCLES,
+  PERF_INSTRUCTIONS,
+  PERF_BRANCH_MISSES,
+  PERF_CACHE_MISSES,
+  PERF_COUNTER_COUNT
+};
+
+struct perf_sample {
+  double seconds = 0.0;
+  uint64_t value[PERF_COUNTER_COUNT] = {};
+  bool valid[PERF_COUNTER_COUNT] = {};
+
+  double ipc() const {
+    return valid[PERF_CYCLES] && valid[PERF_INSTRUCTIONS] && value[PERF_CYCLES] ? double(value[PERF_INSTRUCTIONS]) / value[PERF_CYCLES] : 0.0;
+  }
+  // add another sample, e.g. to total several phases
+  void add(const perf_sample& other);
+};
+
+class perf_counters {
+public:
+  // opens whichever counters the kernel allows; never fails, check available()
+  perf_counters();
+  ~perf_counters();
+  perf_counters(const perf_counters&) = delete;
+  perf_counters& operator=(const perf_counters&) = delete;
+
+  // true if at least one hardware counter opened
+  bool available() const;
+  // why counters are missing, empty if all opened
+  const std::string& unavailable_reason() const { return reason_; }
+
+  void start();
+  perf_sample stop();
+
+private:
+  int fd_[PERF_COUNTER_COUNT];
+  std::string reason_;
+  int64_t start_ns_ = 0;
+};
+
+// format a sample as one table row: wall time, then each counter or "-" if unavailable
+std::string perf_sample_row(const perf_sample& sample);
+std::string perf_sample_header();
+
+#endif
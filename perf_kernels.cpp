@@ -0,0 +1,154 @@
+/* ----------------------------------------------------------
+**
+**
+**   Per-phase hardware counters for the kernel variants
+**
+**   Measures the colour-map build, iterate, colourise and write
+**   phases of each kernel variant with perf_event_open counters
+**   (cycles, instructions, IPC, branch and cache misses), or
+**   wall time alone where counters are not permitted.
+**
+**   usage: perf_kernels [--threads N] [--reps R] [--size WxH]
+**                       [--out dir] [--variant name]
+**
+**   Luke Rule
+**
+---------------------------------------------------------- */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <thread>
+#include <functional>
+#include <algorithm>
+
+#include "mandelbrot_renderer.h"
+#include "perf_counters.h"
+
+struct perf_view {
+  const char* name;
+  double x;
+  double y;
+  int zoom;
+  int max_iterations;
+};
+
+// a way of filling the renderer's iteration buffer for a view
+struct kernel_variant {
+  std::string name;
+  buffer_layout layout;
+  std::function<void(Renderer&, const coord_step&, int)> iterate;
+};
+
+static fixed_32 to_fixed(double value) {
+  return fixed_32(int64_t(value * (1 << FRAC_BITS)));
+}
+
+// lowest wall-time sample of reps runs of work
+static perf_sample measure(perf_counters& counters, int reps, const std::function<void()>& work) {
+  perf_sample best;
+  best.seconds = 1e30;
+  for (int r = 0; r < reps; r++) {
+    counters.start();
+    work();
+    perf_sample sample = counters.stop();
+    if (sample.seconds < best.seconds) {
+      best = sample;
+    }
+  }
+  return best;
+}
+
+int main(int argc, char** argv)
+{
+  int threads = std::max(1u, std::thread::hardware_concurrency());
+  int reps = 3;
+  int width = DEFAULT_XSIZE;
+  int height = DEFAULT_YSIZE;
+  std::string out_dir = "/tmp";
+  std::string only_variant;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+      threads = std::max(1, atoi(argv[++i]));
+    }
+    else if (strcmp(argv[i], "--reps") == 0 && i + 1 < argc) {
+      reps = std::max(1, atoi(argv[++i]));
+    }
+    else if (strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+      if (sscanf(argv[++i], "%dx%d", &width, &height) != 2 || width < 1 || height < 1 || width > MAX_XSIZE || height > MAX_YSIZE) {
+        fprintf(stderr, "bad size\n");
+        return 1;
+      }
+    }
+    else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc) {
+      out_dir = argv[++i];
+    }
+    else if (strcmp(argv[i], "--variant") == 0 && i + 1 < argc) {
+      only_variant = argv[++i];
+    }
+  }
+
+  const perf_view views[] = {
+    {"full", -0.5, 0.0, 0, 180},
+    {"seahorse", -0.745, 0.186, 6, 511},
+    {"exterior", 2.0, 1.5, 0, 180},
+  };
+  std::string n = std::to_string(threads);
+  const kernel_variant variants[] = {
+    {"rows x1", LAYOUT_ROW_MAJOR, [](Renderer& r, const coord_step& c, int max) { r.iterate(c, max, 1); }},
+    {"rows x" + n, LAYOUT_ROW_MAJOR, [threads](Renderer& r, const coord_step& c, int max) { r.iterate(c, max, threads); }},
+    {"tiles x" + n, LAYOUT_TILED, [threads](Renderer& r, const coord_step& c, int max) { r.iterate(c, max, threads); }},
+  };
+
+  perf_counters counters;
+  if (!counters.available()) {
+    printf("hardware counters unavailable, %s; reporting wall time only\n", counters.unavailable_reason().c_str());
+  }
+  else if (!counters.unavailable_reason().empty()) {
+    printf("some counters unavailable, %s\n", counters.unavailable_reason().c_str());
+  }
+  printf("%dx%d, best of %d\n\n", width, height, reps);
+
+  const colour palette[6] = {0x001f, 0x07ff, 0x07e0, 0xffe0, 0xf800, 0xf81f};
+  Renderer renderer(width, height);
+  std::string values = out_dir + "/perf_kernels_output.txt";
+  printf("%-10s %-14s %-11s %s\n", "view", "variant", "phase", perf_sample_header().c_str());
+  for (const perf_view& v : views) {
+    coord_step c = renderer.view(to_fixed(v.x), to_fixed(v.y), v.zoom);
+
+    // the fused reference kernel: iterate and colour in one pass, nothing to split into phases
+    if (only_variant.empty() || only_variant == "drawMandelbrot") {
+      renderer.build_colour_map(palette, v.max_iterations);
+      perf_sample fused = measure(counters, reps, [&] {
+        drawMandelbrot(c.x, c.y, c.step, v.max_iterations, renderer.framebuffer(), width, height, renderer.stride(), renderer.colour_map());
+      });
+      printf("%-10s %-14s %-11s %s\n", v.name, "drawMandelbrot", "render", perf_sample_row(fused).c_str());
+    }
+
+    for (const kernel_variant& k : variants) {
+      if (!only_variant.empty() && only_variant != k.name) {
+        continue;
+      }
+      renderer.set_layout(k.layout);
+      perf_sample phases[4];
+      const char* names[4] = {"colour map", "iterate", "colourise", "write"};
+      phases[0] = measure(counters, reps, [&] { renderer.build_colour_map(palette, v.max_iterations); });
+      phases[1] = measure(counters, reps, [&] { k.iterate(renderer, c, v.max_iterations); });
+      phases[2] = measure(counters, reps, [&] { renderer.colourise(); });
+      phases[3] = measure(counters, 1, [&] { write_framebuffer_file(values, renderer.framebuffer(), width, height, renderer.stride()); });
+      perf_sample total;
+      for (int p = 0; p < 4; p++) {
+        printf("%-10s %-14s %-11s %s\n", v.name, k.name.c_str(), names[p], perf_sample_row(phases[p]).c_str());
+        if (p == 0) {
+          total = phases[p];
+        }
+        else {
+          total.add(phases[p]);
+        }
+      }
+      printf("%-10s %-14s %-11s %s\n", v.name, k.name.c_str(), "total", perf_sample_row(total).c_str());
+    }
+  }
+  remove(values.c_str());
+}
@@ -0,0 +1,881 @@
+/* ----------------------------------------------------------
+**
+**
+**   Interchangeable point kernels
+**
+**   Luke Rule
+**
+---------------------------------------------------------- */
+#include "point_kernels.h"
+
+#include <string.h>
+#include <thread>
+#include <utility>
+#include <algorithm>
+
+#include "mandelbrot_renderer.h"
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#define POINT_KERNELS_X86
+#endif
+
+void scalar_point_kernel(const fixed_32* x, const fixed_32* y, int count, int max_iterations, uint16_t* iterations) {
+  for (int i = 0; i < count; i++) {
+    iterations[i] = iterate_point(x[i], y[i], max_iterations);
+  }
+}
+
+// written out again from the equation rather than sharing iterate_point, so the two can catch each other
+void int128_point_kernel(const fixed_32* x, const fixed_32* y, int count, int max_iterations, uint16_t* iterations) {
+  const __int128 escape = __int128(4) << FRAC_BITS;
+  for (int i = 0; i < count; i++) {
+    __int128 zr = 0;
+    __int128 zi = 0;
+    __int128 modulus_sq = 0;
+    int n = 0;
+    while (modulus_sq <= escape && n < max_iterations) {
+      __int128 zr_sq = (zr * zr) >> FRAC_BITS;
+      __int128 zi_sq = (zi * zi) >> FRAC_BITS;
+      __int128 cross = (zr * zi) >> FRAC_BITS;
+      modulus_sq = zr_sq + zi_sq;
+      zr = zr_sq - zi_sq + x[i];
+      zi = cross * 2 + y[i];
+      n++;
+    }
+    iterations[i] = n;
+  }
+}
+
+// Only bits 31:0 of z_real and z_imaginary reach the multipliers, so z is kept as 32 bits that
+// wrap. The products of two 32-bit operands fit in 64 bits, and the sum of squares in 64 unsigned.
+static inline fixed_64 rtl_mult(fixed_32 a, fixed_32 b) {
+  return (fixed_64(a) * fixed_64(b)) >> FRAC_BITS;
+}
+
+void rtl_point_kernel(const fixed_32* x, const fixed_32* y, int count, int max_iterations, uint16_t* iterations) {
+  for (int i = 0; i < count; i++) {
+    fixed_32 zr = 0;
+    fixed_32 zi = 0;
+    unsigned_fixed_64 modulus_sq = 0;
+    int n = 0;
+    while (modulus_sq <= (4ULL << FRAC_BITS) && n < max_iterations) {
+      modulus_sq = rtl_mult(zr, zr) + rtl_mult(zi, zi);
+      fixed_64 temp = rtl_mult(zr, zr) - rtl_mult(zi, zi) + x[i];
+      zi = fixed_32(unsigned_fixed_64((rtl_mult(zi, zr) << 1) + y[i]));
+      zr = fixed_32(unsigned_fixed_64(temp));
+      n++;
+    }
+    iterations[i] = n;
+  }
+}
+
+// The loop with each distinct product computed once: zr^2 feeds both modulus_sq and zr, zi^2
+// likewise, so three multiplies replace the five written out in iterate_point and
+// mandelbrot_point.sv, with the same products and so the same counts.
+void three_mult_point_kernel(const fixed_32* x, const fixed_32* y, int count, int max_iterations, uint16_t* iterations) {
+  for (int i = 0; i < count; i++) {
+    fixed_64 zr = 0;
+    fixed_64 zi = 0;
+    unsigned_fixed_64 modulus_sq = 0;
+    int n = 0;
+    while (modulus_sq <= (4ULL << FRAC_BITS) && n < max_iterations) {
+      fixed_64 zr_sq = fixed_mult(zr, zr);
+      fixed_64 zi_sq = fixed_mult(zi, zi);
+      fixed_64 cross = fixed_mult(zr, zi);
+      modulus_sq = zr_sq + zi_sq;
+      zr = zr_sq - zi_sq + x[i];
+      zi = (cross << 1) + y[i];
+      n++;
+    }
+    iterations[i] = n;
+  }
+}
+
+void rtl_three_mult_point_kernel(const fixed_32* x, const fixed_32* y, int count, int max_iterations, uint16_t* iterations) {
+  for (int i = 0; i < count; i++) {
+    fixed_32 zr = 0;
+    fixed_32 zi = 0;
+    unsigned_fixed_64 modulus_sq = 0;
+    int n = 0;
+    while (modulus_sq <= (4ULL << FRAC_BITS) && n < max_iterations) {
+      fixed_64 zr_sq = rtl_mult(zr, zr);
+      fixed_64 zi_sq = rtl_mult(zi, zi);
+      fixed_64 cross = rtl_mult(zi, zr);
+      modulus_sq = zr_sq + zi_sq;
+      zi = fixed_32(unsigned_fixed_64((cross << 1) + y[i]));
+      zr = fixed_32(unsigned_fixed_64(zr_sq - zi_sq + x[i]));
+      n++;
+    }
+    iterations[i] = n;
+  }
+}
+
+// the points of a point_kernel call, in order
+struct array_source {
+  const fixed_32* x;
+  const fixed_32* y;
+  uint16_t* iterations;
+  int count;
+  int next = 0;
+
+  bool take(size_t& index, int64_t& cx, int64_t& cy) {
+    if (next >= count) {
+      return false;
+    }
+    index = next;
+    cx = x[next];
+    cy = y[next];
+    next++;
+    return true;
+  }
+  void write(size_t index, int64_t n) { iterations[index] = n; }
+};
+
+// The pixel queue of one thread: rows first_row, first_row + row_step, ... of a frame, left to
+// right. c is stepped as iterateMandelbrotRows steps it, and counts go straight to their pixel.
+struct grid_source {
+  fixed_32 x_fixed;
+  fixed_32 y_fixed;
+  fixed_32 inc_fixed;
+  uint16_t* iteration_buffer;
+  int width;
+  int height;
+  size_t stride;
+  int row_step;
+  int x = 0;
+  int y;
+  fixed_32 x_pos;
+  fixed_32 y_pos;
+
+  grid_source(fixed_32 x_fixed, fixed_32 y_fixed, fixed_32 inc_fixed, uint16_t* iteration_buffer, int width, int height, size_t stride, int first_row, int row_step)
+    : x_fixed(x_fixed), y_fixed(y_fixed), inc_fixed(inc_fixed), iteration_buffer(iteration_buffer), width(width), height(height), stride(stride),
+      row_step(row_step), y(first_row), x_pos(x_fixed), y_pos(step_coord(y_fixed, inc_fixed, -first_row)) {}
+
+  bool take(size_t& index, int64_t& cx, int64_t& cy) {
+    if (y >= height) {
+      return false;
+    }
+    index = y * stride + x;
+    cx = x_pos;
+    cy = y_pos;
+    x_pos = step_coord(x_pos, inc_fixed, 1);
+    if (++x == width) {
+      x = 0;
+      y += row_step;
+      x_pos = x_fixed;
+      y_pos = step_coord(y_fixed, inc_fixed, -y);
+    }
+    return true;
+  }
+  void write(size_t index, int64_t n) { iteration_buffer[index] = n; }
+};
+
+// f(0), f(1), ... f(N - 1) written out, so that once f is inlined every orbit index is a
+// constant and the orbits' state lives in registers rather than in arrays
+template <class F, int... K>
+static inline void unrolled(F&& f, std::integer_sequence<int, K...>) {
+  (f(K), ...);
+}
+
+template <int N, class F>
+static inline void for_each_orbit(F&& f) {
+  unrolled(f, std::make_integer_sequence<int, N>());
+}
+
+// N orbits advanced one step each in turn. Each step of an orbit depends on its previous step
+// through a multiply, but the N orbits do not depend on each other, so their multiplies overlap
+// in the pipeline instead of each waiting out the latency of the last. One branch per round
+// tests all N escape conditions; an orbit that has finished writes its count and takes the next
+// point, like a SIMD lane. Once the source runs dry the remaining orbits are finished one by one.
+template <int N, class source>
+static void interleaved_orbits(source& points, int max_iterations) {
+  int64_t cx[N];
+  int64_t cy[N];
+  fixed_64 zr[N];
+  fixed_64 zi[N];
+  unsigned_fixed_64 modulus_sq[N];
+  int n[N];
+  size_t index[N];
+  // an orbit with no point left keeps this index and is never written
+  const size_t no_point = SIZE_MAX;
+  bool running = true;
+  auto start = [&](int k) {
+    zr[k] = 0;
+    zi[k] = 0;
+    modulus_sq[k] = 0;
+    n[k] = 0;
+    if (!points.take(index[k], cx[k], cy[k])) {
+      index[k] = no_point;
+      cx[k] = 0;
+      cy[k] = 0;
+      running = false;
+    }
+  };
+  auto in_flight = [&](int k) {
+    return (modulus_sq[k] <= (4ULL << FRAC_BITS)) & (n[k] < max_iterations);
+  };
+  auto step = [&](int k) {
+    modulus_sq[k] = fixed_mult(zr[k],zr[k]) + fixed_mult(zi[k],zi[k]);
+    fixed_64 temp = fixed_mult(zr[k],zr[k]) - fixed_mult(zi[k],zi[k]) + cx[k];
+    zi[k] = (fixed_mult(zr[k],zi[k]) << 1) + cy[k];
+    zr[k] = temp;
+    n[k]++;
+  };
+  for_each_orbit<N>(start);
+
+  while (running) {
+    bool finished = false;
+    for_each_orbit<N>([&](int k) { finished |= !in_flight(k); });
+    if (finished) {
+      for_each_orbit<N>([&](int k) {
+        if (!in_flight(k) && running) {
+          points.write(index[k], n[k]);
+          start(k);
+        }
+      });
+      if (!running) {
+        break;
+      }
+    }
+    for_each_orbit<N>(step);
+  }
+
+  // the source is empty: finish the orbits still in flight one at a time
+  for_each_orbit<N>([&](int k) {
+    if (index[k] == no_point) {
+      return;
+    }
+    while (in_flight(k)) {
+      step(k);
+    }
+    points.write(index[k], n[k]);
+  });
+}
+
+template <int N>
+void interleaved_point_kernel(const fixed_32* x, const fixed_32* y, int count, int max_iterations, uint16_t* iterations) {
+  array_source points = {x, y, iterations, count};
+  interleaved_orbits<N>(points, max_iterations);
+}
+
+template <int N>
+static void interleaved_rows(fixed_32 x_fixed, fixed_32 y_fixed, fixed_32 inc_fixed, int max_iterations, uint16_t* iteration_buffer, int width, int height, size_t stride,
+                             int first_row, int row_step) {
+  grid_source points(x_fixed, y_fixed, inc_fixed, iteration_buffer, width, height, stride, first_row, row_step);
+  interleaved_orbits<N>(points, max_iterations);
+}
+
+template <int N>
+void iterateMandelbrotInterleaved(fixed_32 x_fixed, fixed_32 y_fixed, fixed_32 inc_fixed, int max_iterations, uint16_t* iteration_buffer, int width, int height, size_t stride,
+                                  int threads) {
+  if (threads <= 1) {
+    interleaved_rows<N>(x_fixed, y_fixed, inc_fixed, max_iterations, iteration_buffer, width, height, stride, 0, 1);
+    return;
+  }
+  std::vector<std::thread> workers;
+  for (int t = 0; t < threads; t++) {
+    workers.emplace_back(interleaved_rows<N>, x_fixed, y_fixed, inc_fixed, max_iterations, iteration_buffer, width, height, stride, t, threads);
+  }
+  for (std::thread& worker : workers) {
+    worker.join();
+  }
+}
+
+#define INSTANTIATE_INTERLEAVED(N) \
+  template void interleaved_point_kernel<N>(const fixed_32*, const fixed_32*, int, int, uint16_t*); \
+  template void iterateMandelbrotInterleaved<N>(fixed_32, fixed_32, fixed_32, int, uint16_t*, int, int, size_t, int);
+INSTANTIATE_INTERLEAVED(2)
+INSTANTIATE_INTERLEAVED(3)
+INSTANTIATE_INTERLEAVED(4)
+INSTANTIATE_INTERLEAVED(5)
+INSTANTIATE_INTERLEAVED(6)
+INSTANTIATE_INTERLEAVED(7)
+INSTANTIATE_INTERLEAVED(8)
+
+// The escape loop from a state that passed its last check: step until the check fails. Both
+// the start of an orbit and a checkpoint of the unrolled kernels are such states, and as the
+// first step always runs, modulus_sq can start at 0 whatever z is.
+static inline int replay_orbit(fixed_64 zr, fixed_64 zi, int n, int64_t cx, int64_t cy, int max_iterations) {
+  unsigned_fixed_64 modulus_sq = 0;
+  while ((modulus_sq <= (4ULL << FRAC_BITS)) && (n < max_iterations)) {
+    modulus_sq = fixed_mult(zr,zr) + fixed_mult(zi,zi);
+    fixed_64 temp = fixed_mult(zr,zr) - fixed_mult(zi,zi) + cx;
+    zi = (fixed_mult(zr,zi) << 1) + cy;
+    zr = temp;
+    n++;
+  }
+  return n;
+}
+
+// K steps at a time with a single branch: a block that would pass max_iterations is not
+// started, and one in which any step escaped is undone and replayed one step at a time from
+// its checkpoint. The escape test is sticky across the block, as a z past the limit can wrap
+// back under it. The counts are those of iterate_point.
+template <int K>
+static inline int unrolled_orbit(int64_t cx, int64_t cy, int max_iterations) {
+  fixed_64 zr = 0;
+  fixed_64 zi = 0;
+  int n = 0;
+  while (n + K <= max_iterations) {
+    fixed_64 checkpoint_zr = zr;
+    fixed_64 checkpoint_zi = zi;
+    bool escaped = false;
+    unrolled([&](int) {
+      unsigned_fixed_64 modulus_sq = fixed_mult(zr,zr) + fixed_mult(zi,zi);
+      fixed_64 temp = fixed_mult(zr,zr) - fixed_mult(zi,zi) + cx;
+      zi = (fixed_mult(zr,zi) << 1) + cy;
+      zr = temp;
+      escaped |= modulus_sq > (4ULL << FRAC_BITS);
+    }, std::make_integer_sequence<int, K>());
+    if (escaped) {
+      zr = checkpoint_zr;
+      zi = checkpoint_zi;
+      break;
+    }
+    n += K;
+  }
+  return replay_orbit(zr, zi, n, cx, cy, max_iterations);
+}
+
+template <int K, class source>
+static void unrolled_orbits(source& points, int max_iterations) {
+  size_t index;
+  int64_t cx;
+  int64_t cy;
+  while (points.take(index, cx, cy)) {
+    points.write(index, unrolled_orbit<K>(cx, cy, max_iterations));
+  }
+}
+
+template <int K>
+void unrolled_point_kernel(const fixed_32* x, const fixed_32* y, int count, int max_iterations, uint16_t* iterations) {
+  array_source points = {x, y, iterations, count};
+  unrolled_orbits<K>(points, max_iterations);
+}
+
+template void unrolled_point_kernel<4>(const fixed_32*, const fixed_32*, int, int, uint16_t*);
+template void unrolled_point_kernel<8>(const fixed_32*, const fixed_32*, int, int, uint16_t*);
+template void unrolled_point_kernel<16>(const fixed_32*, const fixed_32*, int, int, uint16_t*);
+
+#if defined(POINT_KERNELS_X86)
+// The SIMD kernels keep each lane's z in 64 bits and wrap products exactly as the scalar int64
+// multiply does, so they agree with iterate_point everywhere, overflow included. Points rarely
+// escape together, so rather than wait for the slowest lane of a group, a lane whose point is
+// finished writes its count and takes the next point from the source straight away. Lane state
+// is touched only on those steps, and only for the lanes that change. The fixed-group schedule,
+// the usual way of writing such a kernel, instead refills all lanes at once when the last of
+// them finishes; it is kept as the baseline lane_stats are compared with.
+struct simd_lanes {
+  alignas(64) int64_t cx[8];
+  alignas(64) int64_t cy[8];
+  alignas(64) int64_t count[8];
+  size_t index[8];
+  unsigned live = 0;          // lanes holding a point
+  uint64_t iterations = 0;    // counts written so far
+};
+
+// Write out the counts of the finished lanes and give them new points; returns the lanes that
+// took one, which start again from z = 0 and count = 0. A fresh lane passes its first escape
+// check (max_iterations >= 1), and the step after a refill recomputes modulus_sq from z = 0,
+// so modulus_sq never needs resetting. Lanes left without a point drop out of live.
+template <class source>
+static unsigned refill_lanes(simd_lanes& lanes, unsigned done, source& points) {
+  unsigned refilled = 0;
+  for (int lane = 0; done != 0; lane++, done >>= 1) {
+    if (!(done & 1)) {
+      continue;
+    }
+    if (lanes.live & (1u << lane)) {
+      points.write(lanes.index[lane], lanes.count[lane]);
+      lanes.iterations += lanes.count[lane];
+    }
+    if (points.take(lanes.index[lane], lanes.cx[lane], lanes.cy[lane])) {
+      lanes.live |= 1u << lane;
+      refilled |= 1u << lane;
+    }
+    else {
+      lanes.live &= ~(1u << lane);
+    }
+  }
+  return refilled;
+}
+
+static void add_lane_stats(lane_stats* stats, int lanes, uint64_t steps, uint64_t iterations) {
+  if (stats != nullptr) {
+    stats->lanes = lanes;
+    stats->steps += steps;
+    stats->iterations += iterations;
+  }
+}
+
+// low 64 bits of a * b from 32x32 multiplies, as AVX2 has no 64-bit multiply
+__attribute__((target("avx2"))) static inline __m256i mullo_epi64(__m256i a, __m256i b) {
+  __m256i cross = _mm256_add_epi64(_mm256_mul_epu32(_mm256_srli_epi64(a, 32), b), _mm256_mul_epu32(a, _mm256_srli_epi64(b, 32)));
+  return _mm256_add_epi64(_mm256_mul_epu32(a, b), _mm256_slli_epi64(cross, 32));
+}
+
+__attribute__((target("avx2"))) static inline __m256i square_epi64(__m256i a) {
+  __m256i cross = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), a);
+  return _mm256_add_epi64(_mm256_mul_epu32(a, a), _mm256_slli_epi64(cross, 33));
+}
+
+// arithmetic shift right by FRAC_BITS, also missing from AVX2
+__attribute__((target("avx2"))) static inline __m256i fixed_shift(__m256i v) {
+  __m256i sign = _mm256_cmpgt_epi64(_mm256_setzero_si256(), v);
+  return _mm256_or_si256(_mm256_srli_epi64(v, FRAC_BITS), _mm256_slli_epi64(sign, 64 - FRAC_BITS));
+}
+
+// every point of the source through 4 lanes; max_iterations >= 1
+template <class source>
+__attribute__((target("avx2"))) static void avx2_lanes(source& points, int max_iterations, simd_schedule schedule, lane_stats* stats) {
+  simd_lanes lanes;
+  if (refill_lanes(lanes, 0xf, points) == 0) {
+    return;
+  }
+  bool fixed_groups = schedule == SIMD_FIXED_GROUPS;
+  uint64_t steps = 0;
+  // modulus_sq <= 4 as unsigned is 0 <= modulus_sq < 4 + 1 as signed
+  const __m256i limit = _mm256_set1_epi64x((4LL << FRAC_BITS) + 1);
+  const __m256i negative_one = _mm256_set1_epi64x(-1);
+  const __m256i max = _mm256_set1_epi64x(max_iterations);
+  const __m256i lane_bits = _mm256_set_epi64x(8, 4, 2, 1);
+  __m256i cx = _mm256_load_si256(reinterpret_cast<const __m256i*>(lanes.cx));
+  __m256i cy = _mm256_load_si256(reinterpret_cast<const __m256i*>(lanes.cy));
+  __m256i zr = _mm256_setzero_si256();
+  __m256i zi = _mm256_setzero_si256();
+  __m256i modulus_sq = _mm256_setzero_si256();
+  __m256i n = _mm256_setzero_si256();
+  // lanes of the current group still iterating, fixed groups only
+  __m256i active = negative_one;
+  while (true) {
+    __m256i running = _mm256_and_si256(_mm256_and_si256(_mm256_cmpgt_epi64(limit, modulus_sq), _mm256_cmpgt_epi64(modulus_sq, negative_one)),
+                                       _mm256_cmpgt_epi64(max, n));
+    if (fixed_groups) {
+      // a finished lane stays finished: a wrapped z can fall back under the limit
+      running = _mm256_and_si256(running, active);
+      active = running;
+    }
+    unsigned done = ~_mm256_movemask_pd(_mm256_castsi256_pd(running)) & lanes.live;
+    if (fixed_groups ? done == lanes.live : done != 0) {
+      _mm256_store_si256(reinterpret_cast<__m256i*>(lanes.count), n);
+      unsigned refilled = refill_lanes(lanes, done, points);
+      if (lanes.live == 0) {
+        break;
+      }
+      __m256i fresh = _mm256_cmpeq_epi64(_mm256_and_si256(_mm256_set1_epi64x(refilled), lane_bits), lane_bits);
+      cx = _mm256_blendv_epi8(cx, _mm256_load_si256(reinterpret_cast<const __m256i*>(lanes.cx)), fresh);
+      cy = _mm256_blendv_epi8(cy, _mm256_load_si256(reinterpret_cast<const __m256i*>(lanes.cy)), fresh);
+      zr = _mm256_andnot_si256(fresh, zr);
+      zi = _mm256_andnot_si256(fresh, zi);
+      n = _mm256_andnot_si256(fresh, n);
+      active = negative_one;
+      running = negative_one;
+    }
+    // empty lanes count too, harmlessly, as nothing reads them; in fixed groups finished lanes hold their count
+    n = _mm256_sub_epi64(n, fixed_groups ? running : negative_one);
+    __m256i zr_sq = fixed_shift(square_epi64(zr));
+    __m256i zi_sq = fixed_shift(square_epi64(zi));
+    __m256i cross = fixed_shift(mullo_epi64(zr, zi));
+    modulus_sq = _mm256_add_epi64(zr_sq, zi_sq);
+    zi = _mm256_add_epi64(_mm256_slli_epi64(cross, 1), cy);
+    zr = _mm256_add_epi64(_mm256_sub_epi64(zr_sq, zi_sq), cx);
+    steps++;
+  }
+  add_lane_stats(stats, 4, steps, lanes.iterations);
+}
+
+// Q3.29 product and doubling for 8 lanes. The unmasked shift intrinsics pass GCC's
+// _mm512_undefined_epi32() through, which -Wall reports as maybe uninitialized; the zero-masked
+// forms with every lane selected are the same instructions.
+__attribute__((target("avx512f,avx512dq"))) static inline __m512i fixed_mult_epi64(__m512i a, __m512i b) {
+  return _mm512_maskz_srai_epi64(0xff, _mm512_mullo_epi64(a, b), FRAC_BITS);
+}
+
+__attribute__((target("avx512f"))) static inline __m512i double_epi64(__m512i v) {
+  return _mm512_maskz_slli_epi64(0xff, v, 1);
+}
+
+// AVX-512 has the 64-bit multiply and arithmetic shift, and masks instead of compare vectors
+template <class source>
+__attribute__((target("avx512f,avx512dq"))) static void avx512_lanes(source& points, int max_iterations, simd_schedule schedule, lane_stats* stats) {
+  simd_lanes lanes;
+  if (refill_lanes(lanes, 0xff, points) == 0) {
+    return;
+  }
+  bool fixed_groups = schedule == SIMD_FIXED_GROUPS;
+  uint64_t steps = 0;
+  const __m512i limit = _mm512_set1_epi64(4LL << FRAC_BITS);
+  const __m512i max = _mm512_set1_epi64(max_iterations);
+  const __m512i one = _mm512_set1_epi64(1);
+  __m512i cx = _mm512_load_si512(lanes.cx);
+  __m512i cy = _mm512_load_si512(lanes.cy);
+  __m512i zr = _mm512_setzero_si512();
+  __m512i zi = _mm512_setzero_si512();
+  __m512i modulus_sq = _mm512_setzero_si512();
+  __m512i n = _mm512_setzero_si512();
+  __mmask8 active = 0xff;
+  while (true) {
+    __mmask8 running = _mm512_mask_cmplt_epi64_mask(_mm512_cmple_epu64_mask(modulus_sq, limit), n, max);
+    if (fixed_groups) {
+      running &= active;
+      active = running;
+    }
+    unsigned done = ~unsigned(running) & lanes.live;
+    if (fixed_groups ? done == lanes.live : done != 0) {
+      _mm512_store_si512(lanes.count, n);
+      __mmask8 fresh = refill_lanes(lanes, done, points);
+      if (lanes.live == 0) {
+        break;
+      }
+      cx = _mm512_mask_load_epi64(cx, fresh, lanes.cx);
+      cy = _mm512_mask_load_epi64(cy, fresh, lanes.cy);
+      zr = _mm512_maskz_mov_epi64(~fresh, zr);
+      zi = _mm512_maskz_mov_epi64(~fresh, zi);
+      n = _mm512_maskz_mov_epi64(~fresh, n);
+      active = 0xff;
+      running = 0xff;
+    }
+    n = fixed_groups ? _mm512_mask_add_epi64(n, running, n, one) : _mm512_add_epi64(n, one);
+    __m512i zr_sq = fixed_mult_epi64(zr, zr);
+    __m512i zi_sq = fixed_mult_epi64(zi, zi);
+    __m512i cross = fixed_mult_epi64(zr, zi);
+    modulus_sq = _mm512_add_epi64(zr_sq, zi_sq);
+    zi = _mm512_add_epi64(double_epi64(cross), cy);
+    zr = _mm512_add_epi64(_mm512_sub_epi64(zr_sq, zi_sq), cx);
+    steps++;
+  }
+  add_lane_stats(stats, 8, steps, lanes.iterations);
+}
+
+void avx2_point_kernel(const fixed_32* x, const fixed_32* y, int count, int max_iterations, uint16_t* iterations) {
+  if (max_iterations <= 0) {
+    scalar_point_kernel(x, y, count, max_iterations, iterations);
+    return;
+  }
+  array_source points = {x, y, iterations, count};
+  avx2_lanes(points, max_iterations, SIMD_REFILL, nullptr);
+}
+
+void avx512_point_kernel(const fixed_32* x, const fixed_32* y, int count, int max_iterations, uint16_t* iterations) {
+  if (max_iterations <= 0) {
+    scalar_point_kernel(x, y, count, max_iterations, iterations);
+    return;
+  }
+  array_source points = {x, y, iterations, count};
+  avx512_lanes(points, max_iterations, SIMD_REFILL, nullptr);
+}
+
+// The unrolled SIMD kernels run K steps per lane between checks and keep refilling lanes. A lane
+// that escaped somewhere in the block, or that was too close to max_iterations to start it,
+// finishes with replay_orbit from its checkpoint before taking its next point.
+template <class source>
+static unsigned replay_lanes(simd_lanes& lanes, unsigned done, const int64_t* zr, const int64_t* zi, const int64_t* n, int max_iterations, source& points) {
+  for (int lane = 0; lane < 8; lane++) {
+    if (done & (1u << lane)) {
+      lanes.count[lane] = replay_orbit(zr[lane], zi[lane], int(n[lane]), lanes.cx[lane], lanes.cy[lane], max_iterations);
+    }
+  }
+  return refill_lanes(lanes, done, points);
+}
+
+template <int K, class source>
+__attribute__((target("avx2"))) static void avx2_unrolled_lanes(source& points, int max_iterations) {
+  simd_lanes lanes;
+  if (refill_lanes(lanes, 0xf, points) == 0) {
+    return;
+  }
+  alignas(32) int64_t checkpoint_zr[4];
+  alignas(32) int64_t checkpoint_zi[4];
+  alignas(32) int64_t checkpoint_n[4];
+  const __m256i limit = _mm256_set1_epi64x((4LL << FRAC_BITS) + 1);
+  const __m256i negative_one = _mm256_set1_epi64x(-1);
+  const __m256i last_start = _mm256_set1_epi64x(int64_t(max_iterations) - K);
+  const __m256i block = _mm256_set1_epi64x(K);
+  const __m256i lane_bits = _mm256_set_epi64x(8, 4, 2, 1);
+  __m256i cx = _mm256_load_si256(reinterpret_cast<const __m256i*>(lanes.cx));
+  __m256i cy = _mm256_load_si256(reinterpret_cast<const __m256i*>(lanes.cy));
+  __m256i zr = _mm256_setzero_si256();
+  __m256i zi = _mm256_setzero_si256();
+  __m256i n = _mm256_setzero_si256();
+  while (true) {
+    __m256i start_zr = zr;
+    __m256i start_zi = zi;
+    __m256i start_n = n;
+    // lanes whose block stays under the limit and cannot pass max_iterations
+    __m256i inside = _mm256_cmpgt_epi64(last_start, _mm256_sub_epi64(n, _mm256_set1_epi64x(1)));
+    for (int step = 0; step < K; step++) {
+      __m256i zr_sq = fixed_shift(square_epi64(zr));
+      __m256i zi_sq = fixed_shift(square_epi64(zi));
+      __m256i cross = fixed_shift(mullo_epi64(zr, zi));
+      __m256i modulus_sq = _mm256_add_epi64(zr_sq, zi_sq);
+      zi = _mm256_add_epi64(_mm256_slli_epi64(cross, 1), cy);
+      zr = _mm256_add_epi64(_mm256_sub_epi64(zr_sq, zi_sq), cx);
+      inside = _mm256_and_si256(inside, _mm256_and_si256(_mm256_cmpgt_epi64(limit, modulus_sq), _mm256_cmpgt_epi64(modulus_sq, negative_one)));
+    }
+    n = _mm256_add_epi64(n, block);
+    unsigned done = ~_mm256_movemask_pd(_mm256_castsi256_pd(inside)) & lanes.live;
+    if (done != 0) {
+      _mm256_store_si256(reinterpret_cast<__m256i*>(checkpoint_zr), start_zr);
+      _mm256_store_si256(reinterpret_cast<__m256i*>(checkpoint_zi), start_zi);
+      _mm256_store_si256(reinterpret_cast<__m256i*>(checkpoint_n), start_n);
+      unsigned refilled = replay_lanes(lanes, done, checkpoint_zr, checkpoint_zi, checkpoint_n, max_iterations, points);
+      if (lanes.live == 0) {
+        break;
+      }
+      __m256i fresh = _mm256_cmpeq_epi64(_mm256_and_si256(_mm256_set1_epi64x(refilled), lane_bits), lane_bits);
+      cx = _mm256_blendv_epi8(cx, _mm256_load_si256(reinterpret_cast<const __m256i*>(lanes.cx)), fresh);
+      cy = _mm256_blendv_epi8(cy, _mm256_load_si256(reinterpret_cast<const __m256i*>(lanes.cy)), fresh);
+      zr = _mm256_andnot_si256(fresh, zr);
+      zi = _mm256_andnot_si256(fresh, zi);
+      n = _mm256_andnot_si256(fresh, n);
+    }
+  }
+}
+
+template <int K, class source>
+__attribute__((target("avx512f,avx512dq"))) static void avx512_unrolled_lanes(source& points, int max_iterations) {
+  simd_lanes lanes;
+  if (refill_lanes(lanes, 0xff, points) == 0) {
+    return;
+  }
+  alignas(64) int64_t checkpoint_zr[8];
+  alignas(64) int64_t checkpoint_zi[8];
+  alignas(64) int64_t checkpoint_n[8];
+  const __m512i limit = _mm512_set1_epi64(4LL << FRAC_BITS);
+  const __m512i last_start = _mm512_set1_epi64(int64_t(max_iterations) - K);
+  const __m512i block = _mm512_set1_epi64(K);
+  __m512i cx = _mm512_load_si512(lanes.cx);
+  __m512i cy = _mm512_load_si512(lanes.cy);
+  __m512i zr = _mm512_setzero_si512();
+  __m512i zi = _mm512_setzero_si512();
+  __m512i n = _mm512_setzero_si512();
+  while (true) {
+    __m512i start_zr = zr;
+    __m512i start_zi = zi;
+    __m512i start_n = n;
+    __mmask8 inside = _mm512_cmple_epi64_mask(n, last_start);
+    for (int step = 0; step < K; step++) {
+      __m512i zr_sq = fixed_mult_epi64(zr, zr);
+      __m512i zi_sq = fixed_mult_epi64(zi, zi);
+      __m512i cross = fixed_mult_epi64(zr, zi);
+      __m512i modulus_sq = _mm512_add_epi64(zr_sq, zi_sq);
+      zi = _mm512_add_epi64(double_epi64(cross), cy);
+      zr = _mm512_add_epi64(_mm512_sub_epi64(zr_sq, zi_sq), cx);
+      inside = _mm512_mask_cmple_epu64_mask(inside, modulus_sq, limit);
+    }
+    n = _mm512_add_epi64(n, block);
+    unsigned done = ~unsigned(inside) & lanes.live;
+    if (done != 0) {
+      _mm512_store_si512(checkpoint_zr, start_zr);
+      _mm512_store_si512(checkpoint_zi, start_zi);
+      _mm512_store_si512(checkpoint_n, start_n);
+      __mmask8 fresh = replay_lanes(lanes, done, checkpoint_zr, checkpoint_zi, checkpoint_n, max_iterations, points);
+      if (lanes.live == 0) {
+        break;
+      }
+      cx = _mm512_mask_load_epi64(cx, fresh, lanes.cx);
+      cy = _mm512_mask_load_epi64(cy, fresh, lanes.cy);
+      zr = _mm512_maskz_mov_epi64(~fresh, zr);
+      zi = _mm512_maskz_mov_epi64(~fresh, zi);
+      n = _mm512_maskz_mov_epi64(~fresh, n);
+    }
+  }
+}
+
+template <int K>
+void avx2_unrolled_point_kernel(const fixed_32* x, const fixed_32* y, int count, int max_iterations, uint16_t* iterations) {
+  array_source points = {x, y, iterations, count};
+  avx2_unrolled_lanes<K>(points, max_iterations);
+}
+
+template <int K>
+void avx512_unrolled_point_kernel(const fixed_32* x, const fixed_32* y, int count, int max_iterations, uint16_t* iterations) {
+  array_source points = {x, y, iterations, count};
+  avx512_unrolled_lanes<K>(points, max_iterations);
+}
+
+#define INSTANTIATE_UNROLLED_SIMD(K) \
+  template void avx2_unrolled_point_kernel<K>(const fixed_32*, const fixed_32*, int, int, uint16_t*); \
+  template void avx512_unrolled_point_kernel<K>(const fixed_32*, const fixed_32*, int, int, uint16_t*);
+INSTANTIATE_UNROLLED_SIMD(4)
+INSTANTIATE_UNROLLED_SIMD(8)
+INSTANTIATE_UNROLLED_SIMD(16)
+#endif
+
+static bool cpu_has(const char* feature) {
+#if defined(POINT_KERNELS_X86)
+  if (strcmp(feature, "avx2") == 0) {
+    return __builtin_cpu_supports("avx2");
+  }
+  if (strcmp(feature, "avx512") == 0) {
+    return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512dq");
+  }
+#endif
+  return false;
+}
+
+const std::vector<point_kernel_entry>& point_kernels() {
+  static const std::vector<point_kernel_entry> kernels = [] {
+    std::vector<point_kernel_entry> k = {
+      {"scalar", scalar_point_kernel, false, "iterate_point, the model loop"},
+      {"int128", int128_point_kernel, true, "exact 128-bit products"},
+      {"rtl", rtl_point_kernel, true, "32-bit multiplier operands as in mandelbrot_point.sv"},
+      {"three_mult", three_mult_point_kernel, false, "zr^2, zi^2 and zr.zi each multiplied once"},
+      {"interleave4", interleaved_point_kernel<4>, false, "4 scalar orbits interleaved"},
+      {"interleave8", interleaved_point_kernel<8>, false, "8 scalar orbits interleaved"},
+      {"unroll4", unrolled_point_kernel<4>, false, "4 steps between escape checks, replayed from a checkpoint"},
+      {"unroll16", unrolled_point_kernel<16>, false, "16 steps between escape checks"},
+    };
+    // only what this CPU can run
+#if defined(POINT_KERNELS_X86)
+    if (cpu_has("avx2")) {
+      k.push_back({"avx2", avx2_point_kernel, false, "4 lanes, 64-bit multiply from 32x32 products"});
+      k.push_back({"avx2_unroll8", avx2_unrolled_point_kernel<8>, false, "4 lanes, 8 steps between escape checks"});
+    }
+    if (cpu_has("avx512")) {
+      k.push_back({"avx512", avx512_point_kernel, false, "8 lanes"});
+      k.push_back({"avx512_unroll8", avx512_unrolled_point_kernel<8>, false, "8 lanes, 8 steps between escape checks"});
+    }
+#endif
+    return k;
+  }();
+  return kernels;
+}
+
+const point_kernel_entry* find_point_kernel(const std::string& name) {
+  for (const point_kernel_entry& k : point_kernels()) {
+    if (name == k.name) {
+      return &k;
+    }
+  }
+  return nullptr;
+}
+
+point_kernel best_point_kernel() {
+  static const point_kernel best = [] {
+#if defined(POINT_KERNELS_X86)
+    if (cpu_has("avx512")) {
+      return avx512_point_kernel;
+    }
+    if (cpu_has("avx2")) {
+      return avx2_point_kernel;
+    }
+#endif
+    return scalar_point_kernel;
+  }();
+  return best;
+}
+
+// thread t takes blocks t, t + threads, ... so slow regions of a scattered set are shared out
+static void query_blocks(point_kernel kernel, const fixed_32* x, const fixed_32* y, size_t count, int max_iterations, uint16_t* iterations,
+                         int first_block, int block_step) {
+  for (size_t start = size_t(first_block) * POINT_QUERY_BLOCK; start < count; start += size_t(block_step) * POINT_QUERY_BLOCK) {
+    int n = int(std::min<size_t>(POINT_QUERY_BLOCK, count - start));
+    kernel(x + start, y + start, n, max_iterations, iterations + start);
+  }
+}
+
+void queryMandelbrotPoints(const fixed_32* x, const fixed_32* y, size_t count, int max_iterations, uint16_t* iterations, int threads) {
+  point_kernel kernel = best_point_kernel();
+  if (threads <= 1 || count <= POINT_QUERY_BLOCK) {
+    query_blocks(kernel, x, y, count, max_iterations, iterations, 0, 1);
+    return;
+  }
+  std::vector<std::thread> workers;
+  for (int t = 0; t < threads; t++) {
+    workers.emplace_back(query_blocks, kernel, x, y, count, max_iterations, iterations, t, threads);
+  }
+  for (std::thread& worker : workers) {
+    worker.join();
+  }
+}
+
+static void simd_rows(fixed_32 x_fixed, fixed_32 y_fixed, fixed_32 inc_fixed, int max_iterations, uint16_t* iteration_buffer, int width, int height, size_t stride,
+                      int first_row, int row_step, simd_schedule schedule, lane_stats* stats) {
+#if defined(POINT_KERNELS_X86)
+  if (max_iterations >= 1 && (cpu_has("avx512") || cpu_has("avx2"))) {
+    grid_source points(x_fixed, y_fixed, inc_fixed, iteration_buffer, width, height, stride, first_row, row_step);
+    if (cpu_has("avx512")) {
+      avx512_lanes(points, max_iterations, schedule, stats);
+    }
+    else {
+      avx2_lanes(points, max_iterations, schedule, stats);
+    }
+    return;
+  }
+#endif
+  (void)schedule;
+  iterateMandelbrotRows(x_fixed, y_fixed, inc_fixed, max_iterations, iteration_buffer, width, height, stride, first_row, row_step);
+  uint64_t iterations = 0;
+  for (int y = first_row; y < height; y += row_step) {
+    for (int x = 0; x < width; x++) {
+      iterations += iteration_buffer[y * stride + x];
+    }
+  }
+  add_lane_stats(stats, 1, iterations, iterations);
+}
+
+void iterateMandelbrotSIMD(fixed_32 x_fixed, fixed_32 y_fixed, fixed_32 inc_fixed, int max_iterations, uint16_t* iteration_buffer, int width, int height, size_t stride,
+                           int threads, simd_schedule schedule, lane_stats* stats) {
+  threads = std::max(1, std::min(threads, height));
+  std::vector<lane_stats> thread_stats(threads);
+  if (threads == 1) {
+    simd_rows(x_fixed, y_fixed, inc_fixed, max_iterations, iteration_buffer, width, height, stride, 0, 1, schedule, &thread_stats[0]);
+  }
+  else {
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+      workers.emplace_back(simd_rows, x_fixed, y_fixed, inc_fixed, max_iterations, iteration_buffer, width, height, stride, t, threads, schedule, &thread_stats[t]);
+    }
+    for (std::thread& worker : workers) {
+      worker.join();
+    }
+  }
+  if (stats != nullptr) {
+    *stats = lane_stats();
+    for (const lane_stats& s : thread_stats) {
+      stats->lanes = s.lanes;
+      stats->steps += s.steps;
+      stats->iterations += s.iterations;
+    }
+  }
+}
+
+template <int K>
+static void unrolled_rows(fixed_32 x_fixed, fixed_32 y_fixed, fixed_32 inc_fixed, int max_iterations, uint16_t* iteration_buffer, int width, int height, size_t stride,
+                          int first_row, int row_step, bool simd) {
+  grid_source points(x_fixed, y_fixed, inc_fixed, iteration_buffer, width, height, stride, first_row, row_step);
+#if defined(POINT_KERNELS_X86)
+  if (simd && cpu_has("avx512")) {
+    avx512_unrolled_lanes<K>(points, max_iterations);
+    return;
+  }
+  if (simd && cpu_has("avx2")) {
+    avx2_unrolled_lanes<K>(points, max_iterations);
+    return;
+  }
+#endif
+  (void)simd;
+  unrolled_orbits<K>(points, max_iterations);
+}
+
+template <int K>
+void iterateMandelbrotUnrolled(fixed_32 x_fixed, fixed_32 y_fixed, fixed_32 inc_fixed, int max_iterations, uint16_t* iteration_buffer, int width, int height, size_t stride,
+                               int threads, bool simd) {
+  if (threads <= 1) {
+    unrolled_rows<K>(x_fixed, y_fixed, inc_fixed, max_iterations, iteration_buffer, width, height, stride, 0, 1, simd);
+    return;
+  }
+  std::vector<std::thread> workers;
+  for (int t = 0; t < threads; t++) {
+    workers.emplace_back(unrolled_rows<K>, x_fixed, y_fixed, inc_fixed, max_iterations, iteration_buffer, width, height, stride, t, threads, simd);
+  }
+  for (std::thread& worker : workers) {
+    worker.join();
+  }
+}
+
+template void iterateMandelbrotUnrolled<4>(fixed_32, fixed_32, fixed_32, int, uint16_t*, int, int, size_t, int, bool);
+template void iterateMandelbrotUnrolled<8>(fixed_32, fixed_32, fixed_32, int, uint16_t*, int, int, size_t, int, bool);
+template void iterateMandelbrotUnrolled<16>(fixed_32, fixed_32, fixed_32, int, uint16_t*, int, int, size_t, int, bool);
@@ -0,0 +1,125 @@
+/* ----------------------------------------------------------
+**
+**
+**   Interchangeable point kernels
+**
+**   Every way of iterating a batch of points sits behind one
+**   function type so tools can swap kernels, and the fuzzer can
+**   check each against the scalar loop of iterate_point.
+**
+**   queryMandelbrotPoints answers scattered point queries with
+**   the widest SIMD kernel the CPU supports, on several threads,
+**   and iterateMandelbrotSIMD renders whole frames with it.
+**
+**   Luke Rule
+**
+---------------------------------------------------------- */
+#ifndef POINT_KERNELS_H
+#define POINT_KERNELS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+#include "mandelbrot_fixed.h"
+
+// iterations[i] = escape count of c = x[i] + y[i] i, for i < count
+using point_kernel = void (*)(const fixed_32* x, const fixed_32* y, int count, int max_iterations, uint16_t* iterations);
+
+struct point_kernel_entry {
+  const char* name;
+  point_kernel kernel;
+  // a reference re-implementation rather than an optimisation of the model loop. References
+  // model something else (exact products, the RTL datapath), so they may legitimately disagree.
+  bool reference;
+  const char* description;
+};
+
+// the model loop, what every optimised kernel has to match
+void scalar_point_kernel(const fixed_32* x, const fixed_32* y, int count, int max_iterations, uint16_t* iterations);
+
+// the model recurrence with exact 128-bit products, so no product can wrap
+void int128_point_kernel(const fixed_32* x, const fixed_32* y, int count, int max_iterations, uint16_t* iterations);
+
+// mandelbrot_point.sv: FIXED_POINT_MULTIPLY sign-extends the low 32 bits of each z register
+void rtl_point_kernel(const fixed_32* x, const fixed_32* y, int count, int max_iterations, uint16_t* iterations);
+
+// the model loop and the RTL datapath with three multiplies per iteration instead of five, each
+// distinct product formed once and shared: bit-exact with scalar and rtl respectively
+void three_mult_point_kernel(const fixed_32* x, const fixed_32* y, int count, int max_iterations, uint16_t* iterations);
+void rtl_three_mult_point_kernel(const fixed_32* x, const fixed_32* y, int count, int max_iterations, uint16_t* iterations);
+
+// How SIMD lanes take points. SIMD_REFILL hands a lane the next point as soon as its own is
+// finished; SIMD_FIXED_GROUPS runs each group of lanes until its slowest point is finished.
+enum simd_schedule {
+  SIMD_REFILL,
+  SIMD_FIXED_GROUPS
+};
+
+// Lane occupancy of a SIMD run: iterations / (steps * lanes) of the lane slots did useful work.
+// lanes is 1 when no SIMD kernel ran.
+struct lane_stats {
+  int lanes = 0;
+  uint64_t steps = 0;         // vector iterations
+  uint64_t iterations = 0;    // sum of the counts, the useful lane iterations
+  double occupancy() const { return steps == 0 ? 0.0 : double(iterations) / (double(steps) * lanes); }
+};
+
+// N = 2 to 8 independent orbits interleaved in plain scalar code, for targets without 64-bit
+// SIMD multiplies: the multiplies of different orbits overlap instead of each orbit waiting
+// on its own multiply latency
+template <int N>
+void interleaved_point_kernel(const fixed_32* x, const fixed_32* y, int count, int max_iterations, uint16_t* iterations);
+
+// K = 4, 8 or 16 steps between escape checks. A block in which a step escaped is rolled back
+// to its checkpoint and replayed one step at a time, so the counts stay exact
+template <int K>
+void unrolled_point_kernel(const fixed_32* x, const fixed_32* y, int count, int max_iterations, uint16_t* iterations);
+
+#if defined(__x86_64__) && defined(__GNUC__)
+// 4 and 8 lanes of 64-bit z, chosen at run time; only call these where point_kernels() lists them
+void avx2_point_kernel(const fixed_32* x, const fixed_32* y, int count, int max_iterations, uint16_t* iterations);
+void avx512_point_kernel(const fixed_32* x, const fixed_32* y, int count, int max_iterations, uint16_t* iterations);
+// the same lanes with unrolled_point_kernel<K>'s blocks, K = 4, 8 or 16
+template <int K>
+void avx2_unrolled_point_kernel(const fixed_32* x, const fixed_32* y, int count, int max_iterations, uint16_t* iterations);
+template <int K>
+void avx512_unrolled_point_kernel(const fixed_32* x, const fixed_32* y, int count, int max_iterations, uint16_t* iterations);
+#endif
+
+// all kernels this CPU can run, scalar first
+const std::vector<point_kernel_entry>& point_kernels();
+
+// nullptr if no kernel has that name
+const point_kernel_entry* find_point_kernel(const std::string& name);
+
+// the fastest kernel that agrees with the model on this CPU
+point_kernel best_point_kernel();
+
+// points per kernel call in queryMandelbrotPoints, and the unit threads take turns on
+#define POINT_QUERY_BLOCK 4096
+
+// iterations[i] = iterate_point(x[i], y[i], max_iterations), the count drawMandelbrot gives a pixel at that c
+void queryMandelbrotPoints(const fixed_32* x, const fixed_32* y, size_t count, int max_iterations, uint16_t* iterations, int threads = 1);
+
+// The same counts as iterateMandelbrotParallel with interleaved_point_kernel<N>'s scheme: thread t
+// queues rows t, t + threads, ... and keeps N of their pixels in flight. N = 2 to 8.
+template <int N>
+void iterateMandelbrotInterleaved(fixed_32 x_fixed, fixed_32 y_fixed, fixed_32 inc_fixed, int max_iterations, uint16_t* iteration_buffer, int width, int height, size_t stride,
+                                  int threads = 1);
+
+// The same counts as iterateMandelbrotParallel, from the widest SIMD kernel the CPU has. Thread t
+// queues rows t, t + threads, ... pixel by pixel, and its lanes take pixels from that queue as
+// the schedule allows, writing each count straight to its pixel. stats, if given, sums all threads.
+void iterateMandelbrotSIMD(fixed_32 x_fixed, fixed_32 y_fixed, fixed_32 inc_fixed, int max_iterations, uint16_t* iteration_buffer, int width, int height, size_t stride,
+                           int threads = 1, simd_schedule schedule = SIMD_REFILL, lane_stats* stats = nullptr);
+
+// The same counts as iterateMandelbrotParallel, K = 4, 8 or 16 steps between escape checks. With
+// simd the widest SIMD kernel the CPU has runs the blocks on refilled lanes, as in
+// iterateMandelbrotSIMD; without it, or on CPUs without one, each thread runs them pixel by pixel.
+template <int K>
+void iterateMandelbrotUnrolled(fixed_32 x_fixed, fixed_32 y_fixed, fixed_32 inc_fixed, int max_iterations, uint16_t* iteration_buffer, int width, int height, size_t stride,
+                               int threads = 1, bool simd = true);
+
+#endif
@@ -0,0 +1,133 @@
+/* ----------------------------------------------------------
+**
+**
+**   Render cost predictions for an input file
+**
+**   Predicts iterations, model render time and RTL cycles for
+**   every test case from a 1 in 64 pixel sample, longest first,
+**   and optionally checks them against full renders or packs
+**   the cases onto N workers longest-processing-time first.
+**
+**   usage: predict_cost [input file] [--size WxH] [--stride S]
+**                       [--calibrate] [--measure] [--bins N]
+**
+**   Luke Rule
+**
+---------------------------------------------------------- */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+
+#include "mandelbrot_renderer.h"
+#include "batch_render.h"
+#include "cost_predictor.h"
+
+int main(int argc, char** argv)
+{
+  std::string input_file = "/home/p74644lr/Questa/COMP32211/src/Phase_2/input_file.txt";
+  int width = DEFAULT_XSIZE;
+  int height = DEFAULT_YSIZE;
+  int stride = PREDICT_SAMPLE_STRIDE;
+  int bins = 0;
+  bool calibrate = false;
+  bool measure = false;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+      if (sscanf(argv[++i], "%dx%d", &width, &height) != 2 || width < 1 || height < 1 || width > MAX_XSIZE || height > MAX_YSIZE) {
+        fprintf(stderr, "bad size\n");
+        return 1;
+      }
+    }
+    else if (strcmp(argv[i], "--stride") == 0 && i + 1 < argc) {
+      stride = std::max(1, atoi(argv[++i]));
+    }
+    else if (strcmp(argv[i], "--bins") == 0 && i + 1 < argc) {
+      bins = std::max(1, atoi(argv[++i]));
+    }
+    else if (strcmp(argv[i], "--calibrate") == 0) {
+      calibrate = true;
+    }
+    else if (strcmp(argv[i], "--measure") == 0) {
+      measure = true;
+    }
+    else if (argv[i][0] != '-') {
+      input_file = argv[i];
+    }
+  }
+
+  std::vector<test_case> cases = read_test_cases(input_file);
+  if (cases.empty()) {
+    fprintf(stderr, "no test cases in %s\n", input_file.c_str());
+    return 1;
+  }
+  cost_model model;
+  if (calibrate) {
+    model = calibrate_cost_model(width, height);
+    printf("calibrated: %.2f ns per iteration, %.2f ns per pixel\n", model.ns_per_iteration, model.ns_per_pixel);
+  }
+
+  std::vector<cost_prediction> predictions;
+  double sampling = 0.0;
+  for (const test_case& t : cases) {
+    coord_step c = center_coords(t.center_x, t.center_y, t.zoom, width, height);
+    predictions.push_back(predict_render_cost(c, t.max_iterations, width, height, model, stride));
+    sampling += predictions.back().sample_seconds;
+  }
+  std::vector<int> order(cases.size());
+  for (size_t i = 0; i < order.size(); i++) {
+    order[i] = i;
+  }
+  std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return predictions[a].seconds > predictions[b].seconds; });
+
+  Renderer renderer(width, height);
+  double error_sum = 0.0;
+  double error_max = 0.0;
+  printf("%6s %14s %10s %14s", "case", "iterations", "model ms", "RTL cycles");
+  if (measure) {
+    printf(" %14s %10s %8s", "actual iter", "actual ms", "error");
+  }
+  printf("\n");
+  for (int i : order) {
+    const test_case& t = cases[i];
+    const cost_prediction& p = predictions[i];
+    printf("%6d %14llu %10.3f %14llu", t.file_count, (unsigned long long)p.iterations, p.seconds * 1e3, (unsigned long long)p.hardware_cycles);
+    if (measure) {
+      renderer.build_colour_map(t.colours, t.max_iterations);
+      auto start = std::chrono::steady_clock::now();
+      renderer.iterate(center_coords(t.center_x, t.center_y, t.zoom, width, height), t.max_iterations, 1);
+      renderer.colourise();
+      std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+      unsigned long long actual = 0;
+      for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+          actual += renderer.iteration_at(x, y);
+        }
+      }
+      double error = actual ? (double(p.iterations) - double(actual)) / actual : 0.0;
+      error_sum += fabs(error);
+      error_max = std::max(error_max, fabs(error));
+      printf(" %14llu %10.3f %+7.1f%%", actual, elapsed.count() * 1e3, error * 100);
+    }
+    printf("\n");
+  }
+  printf("\n%zu cases predicted in %.3f ms\n", cases.size(), sampling * 1e3);
+  if (measure) {
+    printf("iteration error: mean %.1f%%, max %.1f%%\n", 100 * error_sum / cases.size(), 100 * error_max);
+  }
+
+  // longest processing time first: each case goes to the least loaded worker
+  if (bins > 0) {
+    std::vector<double> load(bins, 0.0);
+    double total = 0.0;
+    for (int i : order) {
+      *std::min_element(load.begin(), load.end()) += predictions[i].seconds;
+      total += predictions[i].seconds;
+    }
+    printf("%d workers: predicted makespan %.3f ms, ideal %.3f ms\n", bins, *std::max_element(load.begin(), load.end()) * 1e3, total / bins * 1e3);
+  }
+}
@@ -0,0 +1,146 @@
+/* ----------------------------------------------------------
+**
+**
+**   Progressive rendering check and timing
+**
+**   Renders the benchmark views with render_progressive and as
+**   one full frame (iterateMandelbrotParallel, then colourise),
+**   checks the final pass matches the full frame in both the
+**   iteration buffer and the framebuffer, and reports the time
+**   of each and of the first, coarsest preview.
+**
+**   usage: progressive_benchmark [--size WxH] [--threads N]
+**                                [--iterations M] [--reps R]
+**                                [--no-fill]
+**
+**   Exits with status 1 if a final pass differs.
+**
+**   Luke Rule
+**
+---------------------------------------------------------- */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+
+#include "mandelbrot_renderer.h"
+#include "progressive_render.h"
+
+struct progressive_view {
+  const char* name;
+  double x;
+  double y;
+  int zoom;
+};
+
+static fixed_32 to_fixed(double value) {
+  return fixed_32(int64_t(value * (1 << FRAC_BITS)));
+}
+
+static double ms_since(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char** argv)
+{
+  int width = DEFAULT_XSIZE;
+  int height = DEFAULT_YSIZE;
+  int threads = 1;
+  int max_iterations = 180;
+  int reps = 3;
+  bool fill_blocks = true;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+      threads = std::max(1, atoi(argv[++i]));
+    }
+    else if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+      max_iterations = std::min(MAX_ITERATIONS, std::max(1, atoi(argv[++i])));
+    }
+    else if (strcmp(argv[i], "--reps") == 0 && i + 1 < argc) {
+      reps = std::max(1, atoi(argv[++i]));
+    }
+    else if (strcmp(argv[i], "--no-fill") == 0) {
+      fill_blocks = false;
+    }
+    else if (strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+      if (sscanf(argv[++i], "%dx%d", &width, &height) != 2 || width < 1 || height < 1 || width > MAX_XSIZE || height > MAX_YSIZE) {
+        fprintf(stderr, "bad size\n");
+        return 1;
+      }
+    }
+  }
+
+  // the fixed windows of test_input_generator.py
+  const progressive_view views[] = {
+    {"full", -0.5, 0.0, 0},
+    {"cardioid_edge", -0.7467, 0.163, 6},
+    {"period2_valley", -0.749, 0.07, 5},
+    {"minibrot", -1.766, 0.0, 5},
+    {"outer_branches", -0.2, -0.865, 3},
+    {"very_zoomed", 0.001643721971153, -0.822467633298876, 8},
+    {"seahorse", -0.745, 0.186, 6},
+    {"elephant", 0.273, 0.007, 7},
+    {"origin", 0.0, 0.0, 0},
+  };
+  const colour palette[6] = {0xf800, 0x07e0, 0x001f, 0xfc00, 0x03ff, 0xf81f};
+
+  Renderer full(width, height);
+  Renderer progressive(width, height);
+  full.build_colour_map(palette, max_iterations);
+  progressive.build_colour_map(palette, max_iterations);
+  std::vector<uint16_t> reference(size_t(width) * height);
+  size_t stride = full.stride();
+
+  printf("%dx%d, %d iterations, %d threads, %s\n\n", width, height, max_iterations, threads, fill_blocks ? "block fill" : "no block fill");
+  printf("%-15s %9s %9s %9s %11s\n", "view", "full ms", "prog ms", "ratio", "preview ms");
+  double full_total = 0.0;
+  double progressive_total = 0.0;
+  bool differ = false;
+  for (const progressive_view& v : views) {
+    coord_step c = center_coords(to_fixed(v.x), to_fixed(v.y), v.zoom, width, height);
+    double full_ms = 1e30;
+    double progressive_ms = 1e30;
+    double preview_ms = 1e30;
+    size_t pixels_done = 0;
+    for (int r = 0; r < reps; r++) {
+      auto start = std::chrono::steady_clock::now();
+      iterateMandelbrotParallel(c.x, c.y, c.step, max_iterations, full.iterations(), width, height, stride, threads);
+      full.colourise();
+      full_ms = std::min(full_ms, ms_since(start));
+
+      progressive.clear(0x7BEF);
+      start = std::chrono::steady_clock::now();
+      render_progressive(progressive, c, max_iterations, [&](int step, size_t done, const Renderer&) {
+        if (step == PROGRESSIVE_START_STEP) {
+          preview_ms = std::min(preview_ms, ms_since(start));
+        }
+        pixels_done = done;
+      }, fill_blocks, threads);
+      progressive_ms = std::min(progressive_ms, ms_since(start));
+    }
+    full_total += full_ms;
+    progressive_total += progressive_ms;
+
+    // the final pass against the full render, both the counts and the colours
+    iterateMandelbrotParallel(c.x, c.y, c.step, max_iterations, reference.data(), width, height, width, threads);
+    uint64_t wrong = 0;
+    for (int y = 0; y < height; y++) {
+      for (int x = 0; x < width; x++) {
+        wrong += progressive.iteration_at(x, y) != reference[size_t(y) * width + x];
+        wrong += progressive.framebuffer()[y * progressive.stride() + x] != full.framebuffer()[y * stride + x];
+      }
+    }
+    bool bad = wrong != 0 || pixels_done != size_t(width) * height;
+    differ = differ || bad;
+    printf("%-15s %9.2f %9.2f %8.2fx %11.2f%s\n", v.name, full_ms, progressive_ms, progressive_ms / full_ms, preview_ms,
+           bad ? "  MISMATCH" : "");
+  }
+  printf("\nall views: full %.1f ms, progressive %.1f ms (%.2fx)\n", full_total, progressive_total, progressive_total / full_total);
+  if (differ) {
+    printf("a final pass differs from the full render\n");
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,72 @@
+/* ----------------------------------------------------------
+**
+**
+**   Progressive coarse-to-fine rendering
+**
+**   Luke Rule
+**
+---------------------------------------------------------- */
+#include "progressive_render.h"
+
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+// one pass over rows first_row, first_row + row_step, ... of the step grid
+static void progressive_rows(Renderer& renderer, const coord_step& c, int max_iterations, int step, bool fill_blocks, int first_row, int row_step) {
+  int width = renderer.width();
+  int height = renderer.height();
+  size_t stride = renderer.stride();
+  colour* framebuffer = renderer.framebuffer();
+  uint16_t* iterations = renderer.iterations();
+  const std::vector<colour>& colour_map = renderer.colour_map();
+
+  for (int y = first_row * step; y < height; y += row_step * step) {
+    fixed_32 y_pos = step_coord(c.y, c.step, -y);
+    // on rows of the previous grid, every other sample was taken by the previous pass
+    bool coarse_row = step < PROGRESSIVE_START_STEP && y % (2 * step) == 0;
+    int x_first = coarse_row ? step : 0;
+    int x_step = coarse_row ? 2 * step : step;
+    int block_height = fill_blocks ? std::min(step, height - y) : 1;
+    for (int x = x_first; x < width; x += x_step) {
+      int count = iterate_point(step_coord(c.x, c.step, x), y_pos, max_iterations);
+      colour value = iteration_colour(count, max_iterations, colour_map);
+      iterations[renderer.iteration_offset(x, y)] = count;
+      if (fill_blocks) {
+        int block_width = std::min(step, width - x);
+        for (int by = 0; by < block_height; by++) {
+          std::fill(framebuffer + (y + by) * stride + x, framebuffer + (y + by) * stride + x + block_width, value);
+        }
+      }
+      else {
+        framebuffer[y * stride + x] = value;
+      }
+    }
+  }
+}
+
+void render_progressive(Renderer& renderer, const coord_step& c, int max_iterations, const progressive_callback& callback, bool fill_blocks, int threads) {
+  size_t pixels_done = 0;
+  for (int step = PROGRESSIVE_START_STEP; step >= 1; step /= 2) {
+    if (threads <= 1) {
+      progressive_rows(renderer, c, max_iterations, step, fill_blocks, 0, 1);
+    }
+    else {
+      std::vector<std::thread> workers;
+      for (int t = 0; t < threads; t++) {
+        workers.emplace_back(progressive_rows, std::ref(renderer), std::cref(c), max_iterations, step, fill_blocks, t, threads);
+      }
+      for (std::thread& worker : workers) {
+        worker.join();
+      }
+    }
+
+    // pixels on this grid, less those already on the coarser one
+    size_t grid = size_t((renderer.width() + step - 1) / step) * ((renderer.height() + step - 1) / step);
+    size_t coarse = step < PROGRESSIVE_START_STEP ? size_t((renderer.width() + 2 * step - 1) / (2 * step)) * ((renderer.height() + 2 * step - 1) / (2 * step)) : 0;
+    pixels_done += grid - coarse;
+    if (callback) {
+      callback(step, pixels_done, renderer);
+    }
+  }
+}
@@ -0,0 +1,34 @@
+/* ----------------------------------------------------------
+**
+**
+**   Progressive coarse-to-fine rendering
+**
+**   Renders every 8th pixel of the step grid first, then every
+**   4th, 2nd and 1st. Every pixel is iterated exactly once, since
+**   a coarse sample has the same c as the fine pixel it lands on.
+**
+**   Luke Rule
+**
+---------------------------------------------------------- */
+#ifndef PROGRESSIVE_RENDER_H
+#define PROGRESSIVE_RENDER_H
+
+#include <functional>
+
+#include "mandelbrot_renderer.h"
+
+// coarsest pass samples every PROGRESSIVE_START_STEP'th pixel in x and y
+#define PROGRESSIVE_START_STEP 8
+
+// Called after each pass with that pass's grid step (8, 4, 2 then 1) and the number of
+// pixels iterated so far. The renderer's framebuffer and iteration buffer are valid at
+// every multiple of step; the final call (step 1) holds the complete frame.
+using progressive_callback = std::function<void(int step, size_t pixels_done, const Renderer& renderer)>;
+
+// Render the view with renderer's current colour map (build_colour_map first). With
+// fill_blocks each sample is also drawn over the step x step block it stands for, which
+// gives a blocky preview instead of scattered dots; block fills only cover pixels that a
+// later pass has not reached, so exact samples are never overwritten.
+void render_progressive(Renderer& renderer, const coord_step& c, int max_iterations, const progressive_callback& callback, bool fill_blocks = true, int threads = 1);
+
+#endif
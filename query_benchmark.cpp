@@ -0,0 +1,130 @@
+/* ----------------------------------------------------------
+**
+**
+**   Point query benchmark
+**
+**   Renders a grid of about --points pixels, then asks
+**   queryMandelbrotPoints for the same c values in shuffled
+**   order, so both do identical work. Checks every count
+**   against the grid render and reports points per second
+**   for the grid, each point kernel, and the threaded query.
+**
+**   usage: query_benchmark [--points N] [--threads N]
+**                          [--iterations M] [--reps R]
+**
+**   Luke Rule
+**
+---------------------------------------------------------- */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <vector>
+#include <random>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include <functional>
+
+#include "mandelbrot_renderer.h"
+#include "point_kernels.h"
+
+static fixed_32 to_fixed(double value) {
+  return fixed_32(int64_t(value * (1 << FRAC_BITS)));
+}
+
+// best wall time of reps runs of work
+static double time_best(int reps, const std::function<void()>& work) {
+  double best = 1e30;
+  for (int r = 0; r < reps; r++) {
+    auto start = std::chrono::steady_clock::now();
+    work();
+    best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+  }
+  return best;
+}
+
+int main(int argc, char** argv)
+{
+  long points = 10000000;
+  int threads = std::max(1u, std::thread::hardware_concurrency());
+  int max_iterations = 180;
+  int reps = 3;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--points") == 0 && i + 1 < argc) {
+      points = std::max(1L, atol(argv[++i]));
+    }
+    else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+      threads = std::max(1, atoi(argv[++i]));
+    }
+    else if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+      max_iterations = std::min(MAX_ITERATIONS, std::max(1, atoi(argv[++i])));
+    }
+    else if (strcmp(argv[i], "--reps") == 0 && i + 1 < argc) {
+      reps = std::max(1, atoi(argv[++i]));
+    }
+  }
+
+  // a 16:10 frame of the whole set at zoom 3, about 3.9 wide at 4000 pixels
+  int width = std::max(1, int(sqrt(points * 1.6)));
+  int height = std::max(1, int(points / width));
+  size_t count = size_t(width) * height;
+  coord_step c = center_coords(to_fixed(-0.75), 0, 3, width, height);
+
+  std::vector<uint16_t> grid(count);
+  double grid_seconds = time_best(reps, [&] {
+    iterateMandelbrotParallel(c.x, c.y, c.step, max_iterations, grid.data(), width, height, width, threads);
+  });
+
+  // the grid's c values, scattered
+  std::vector<uint32_t> order(count);
+  for (size_t i = 0; i < count; i++) {
+    order[i] = i;
+  }
+  std::shuffle(order.begin(), order.end(), std::mt19937_64(1));
+  std::vector<fixed_32> x(count);
+  std::vector<fixed_32> y(count);
+  for (size_t i = 0; i < count; i++) {
+    int px = order[i] % width;
+    int py = order[i] / width;
+    x[i] = step_coord(c.x, c.step, px);
+    y[i] = step_coord(c.y, c.step, -py);
+  }
+
+  std::vector<uint16_t> iterations(count);
+  auto matches_grid = [&] {
+    for (size_t i = 0; i < count; i++) {
+      if (iterations[i] != grid[order[i]]) {
+        fprintf(stderr, "point %zu (pixel %u,%u) gives %d, the grid %d\n", i, order[i] % width, order[i] / width, iterations[i], grid[order[i]]);
+        return false;
+      }
+    }
+    return true;
+  };
+
+  printf("%dx%d = %zu points, max_iterations %d, best of %d\n\n", width, height, count, max_iterations, reps);
+  printf("%-28s %8s %10s %9s\n", "kernel", "threads", "Mpoints/s", "vs grid");
+  printf("%-28s %8d %10.2f %9s\n", "grid (iterateMandelbrot)", threads, count / grid_seconds / 1e6, "1.00x");
+
+  bool ok = true;
+  for (const point_kernel_entry& k : point_kernels()) {
+    if (k.reference) {
+      continue;
+    }
+    double seconds = time_best(reps, [&] {
+      for (size_t start = 0; start < count; start += POINT_QUERY_BLOCK) {
+        int n = int(std::min<size_t>(POINT_QUERY_BLOCK, count - start));
+        k.kernel(x.data() + start, y.data() + start, n, max_iterations, iterations.data() + start);
+      }
+    });
+    ok = matches_grid() && ok;
+    printf("%-28s %8d %10.2f %8.2fx\n", k.name, 1, count / seconds / 1e6, grid_seconds / seconds);
+  }
+  double query_seconds = time_best(reps, [&] {
+    queryMandelbrotPoints(x.data(), y.data(), count, max_iterations, iterations.data(), threads);
+  });
+  ok = matches_grid() && ok;
+  printf("%-28s %8d %10.2f %8.2fx\n", "queryMandelbrotPoints", threads, count / query_seconds / 1e6, grid_seconds / query_seconds);
+  printf("\n%s\n", ok ? "all counts match the grid render" : "COUNTS DIFFER from the grid render");
+  return ok ? 0 : 1;
+}
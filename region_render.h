@@ -0,0 +1,50 @@
+/* ----------------------------------------------------------
+**
+**
+**   Region-of-interest rendering for regression triage
+**
+**   Reads the testbench's pixel_errors.txt and re-renders only
+**   the areas around mismatching pixels
+**
+**   Luke Rule
+**
+---------------------------------------------------------- */
+#ifndef REGION_RENDER_H
+#define REGION_RENDER_H
+
+#include <string>
+#include <vector>
+
+#include "mandelbrot_renderer.h"
+
+// one "Pixel mismatch at X, Y. Expected: E, got: G" line, X and Y being the pixel's screen coordinates
+struct pixel_error {
+  int x;
+  int y;
+  colour expected;
+  colour got;
+  // the testbench printed got as x/X: the RTL never wrote the pixel, and got is meaningless
+  bool undrawn;
+};
+
+// the mismatches listed under one "Test N:" heading
+struct test_errors {
+  int test;
+  std::vector<pixel_error> errors;
+};
+
+// every test in the file, including tests without mismatches; empty if the file cannot be read
+std::vector<test_errors> read_pixel_errors(const std::string& filename);
+
+// Cover the pixels with rectangles: pixels are binned into TILE_SIZE tiles and each occupied
+// tile gives the bounding box of its pixels, so the area rendered stays close to the errors.
+std::vector<pixel_rect> cover_pixels(const std::vector<pixel_error>& errors);
+
+// clip rect to the frame, false if nothing is left
+bool clip_rect(pixel_rect& rect, int width, int height);
+
+// render each rect into its place in a full-frame framebuffer, leaving other pixels untouched;
+// returns the number of pixels rendered
+size_t drawMandelbrotRects(const coord_step& c, int max_iterations, const std::vector<pixel_rect>& rects, colour* framebuffer, int width, int height, size_t stride, const std::vector<colour>& colour_map);
+
+#endif
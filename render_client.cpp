@@ -0,0 +1,135 @@
+/* ----------------------------------------------------------
+**
+**
+**   Render daemon client
+**
+**   Sends every line of an input file to the render daemon,
+**   optionally several times over, and reports round-trip
+**   latency. The last frame can be saved as a PPM.
+**
+**   usage: render_client <input file> [--socket path] [--repeat N]
+**                        [--iterations] [--ppm file.ppm] [--stats]
+**
+**   Luke Rule
+**
+---------------------------------------------------------- */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <chrono>
+#include <algorithm>
+
+#include "mandelbrot_renderer.h"
+#include "render_protocol.h"
+
+static bool read_all(int fd, void* data, size_t bytes) {
+  char* p = static_cast<char*>(data);
+  while (bytes > 0) {
+    ssize_t received = read(fd, p, bytes);
+    if (received <= 0) {
+      return false;
+    }
+    p += received;
+    bytes -= received;
+  }
+  return true;
+}
+
+// send one request line and read its reply
+static bool request(int fd, const std::string& line, daemon_reply_header& header, std::vector<char>& payload) {
+  std::string message = line + "\n";
+  if (write(fd, message.data(), message.size()) != ssize_t(message.size())) {
+    return false;
+  }
+  if (!read_all(fd, &header, sizeof(header)) || header.magic != DAEMON_REPLY_MAGIC) {
+    return false;
+  }
+  payload.resize(header.payload_bytes);
+  return read_all(fd, payload.data(), payload.size());
+}
+
+int main(int argc, char** argv)
+{
+  if (argc < 2) {
+    fprintf(stderr, "usage: render_client <input file> [--socket path] [--repeat N] [--iterations] [--ppm file.ppm] [--stats]\n");
+    return 1;
+  }
+  std::string socket_path = DAEMON_DEFAULT_SOCKET;
+  std::string ppm;
+  int repeat = 1;
+  bool iterations = false;
+  bool stats = false;
+  for (int i = 2; i < argc; i++) {
+    if (strcmp(argv[i], "--socket") == 0 && i + 1 < argc) {
+      socket_path = argv[++i];
+    }
+    else if (strcmp(argv[i], "--repeat") == 0 && i + 1 < argc) {
+      repeat = std::max(1, atoi(argv[++i]));
+    }
+    else if (strcmp(argv[i], "--iterations") == 0) {
+      iterations = true;
+    }
+    else if (strcmp(argv[i], "--ppm") == 0 && i + 1 < argc) {
+      ppm = argv[++i];
+    }
+    else if (strcmp(argv[i], "--stats") == 0) {
+      stats = true;
+    }
+  }
+
+  std::vector<std::string> lines;
+  std::ifstream input(argv[1]);
+  std::string line;
+  while (std::getline(input, line)) {
+    if (line.find_first_not_of(" \t\r") != std::string::npos) {
+      lines.push_back(iterations ? "ITER " + line : line);
+    }
+  }
+
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  struct sockaddr_un address = {};
+  address.sun_family = AF_UNIX;
+  strncpy(address.sun_path, socket_path.c_str(), sizeof(address.sun_path) - 1);
+  if (fd < 0 || connect(fd, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) != 0) {
+    fprintf(stderr, "could not connect to %s\n", socket_path.c_str());
+    return 1;
+  }
+
+  std::vector<double> latencies_us;
+  daemon_reply_header header = {};
+  std::vector<char> payload;
+  for (int r = 0; r < repeat; r++) {
+    for (const std::string& l : lines) {
+      auto start = std::chrono::steady_clock::now();
+      if (!request(fd, l, header, payload)) {
+        fprintf(stderr, "daemon closed the connection\n");
+        return 1;
+      }
+      std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+      latencies_us.push_back(elapsed.count());
+      if (header.status != DAEMON_OK) {
+        fprintf(stderr, "bad request: %s\n", l.c_str());
+      }
+    }
+  }
+
+  if (!latencies_us.empty()) {
+    std::sort(latencies_us.begin(), latencies_us.end());
+    printf("%zu requests: p50 %.1f us, p99 %.1f us, max %.1f us\n", latencies_us.size(),
+           latencies_us[latencies_us.size() / 2], latencies_us[std::min(latencies_us.size() - 1, latencies_us.size() * 99 / 100)],
+           latencies_us.back());
+  }
+  if (!ppm.empty() && header.status == DAEMON_OK && header.format == DAEMON_FORMAT_RGB565) {
+    write_ppm_file(ppm, reinterpret_cast<const colour*>(payload.data()), header.width, header.height, header.width);
+  }
+  if (stats && request(fd, "STATS", header, payload)) {
+    printf("%.*s\n", int(payload.size()), payload.data());
+  }
+  close(fd);
+}
@@ -0,0 +1,357 @@
+/* ----------------------------------------------------------
+**
+**
+**   Local render daemon
+**
+**   Serves frames over a UNIX domain socket (see render_protocol.h),
+**   keeping colour maps and iteration buffers cached between
+**   requests so repeated or re-coloured views skip the work
+**
+**   usage: render_daemon [--socket path] [--size WxH]
+**                        [--frame-threads N] [--iteration-cache N]
+**                        [--palette-cache N]
+**
+**   Luke Rule
+**
+---------------------------------------------------------- */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <array>
+#include <list>
+#include <map>
+#include <tuple>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <sstream>
+#include <algorithm>
+
+#include "mandelbrot_renderer.h"
+#include "batch_render.h"
+#include "render_protocol.h"
+
+// number of recent requests kept for the latency percentiles
+#define LATENCY_WINDOW 65536
+
+static std::atomic<bool> stopping(false);
+
+static void handle_signal(int) {
+  stopping = true;
+}
+
+// Least recently used cache. Values are shared so a request can keep using an entry
+// that another request evicts.
+template <typename Key, typename Value>
+class lru_cache {
+public:
+  explicit lru_cache(size_t capacity) : capacity_(capacity) {}
+
+  std::shared_ptr<const Value> get(const Key& key) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto found = index_.find(key);
+    if (found == index_.end()) {
+      misses_++;
+      return nullptr;
+    }
+    hits_++;
+    entries_.splice(entries_.begin(), entries_, found->second);
+    return found->second->second;
+  }
+
+  void put(const Key& key, std::shared_ptr<const Value> value) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (capacity_ == 0 || index_.count(key)) {
+      return;
+    }
+    entries_.emplace_front(key, value);
+    index_[key] = entries_.begin();
+    if (entries_.size() > capacity_) {
+      index_.erase(entries_.back().first);
+      entries_.pop_back();
+    }
+  }
+
+  double hit_rate() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return hits_ + misses_ == 0 ? 0.0 : double(hits_) / double(hits_ + misses_);
+  }
+
+private:
+  size_t capacity_;
+  std::mutex mutex_;
+  std::list<std::pair<Key, std::shared_ptr<const Value>>> entries_;
+  std::map<Key, typename std::list<std::pair<Key, std::shared_ptr<const Value>>>::iterator> index_;
+  uint64_t hits_ = 0;
+  uint64_t misses_ = 0;
+};
+
+using palette_key = std::array<int, 7>;                        // 6 colours and max iterations
+using geometry_key = std::tuple<fixed_32, fixed_32, fixed_32, int>;  // top-left, step, max iterations
+
+struct daemon_state {
+  int width = DEFAULT_XSIZE;
+  int height = DEFAULT_YSIZE;
+  int frame_threads = 1;
+  lru_cache<palette_key, std::vector<colour>> palettes;
+  lru_cache<geometry_key, std::vector<uint16_t>> iterations;
+
+  std::mutex metrics_mutex;
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  std::vector<uint64_t> latencies_ns;
+  uint64_t requests = 0;
+  uint64_t frames = 0;
+  uint64_t bad_requests = 0;
+
+  daemon_state(size_t palette_capacity, size_t iteration_capacity)
+    : palettes(palette_capacity), iterations(iteration_capacity) {}
+};
+
+static void record_latency(daemon_state& state, uint64_t ns, bool frame, bool bad) {
+  std::lock_guard<std::mutex> lock(state.metrics_mutex);
+  if (state.latencies_ns.size() < LATENCY_WINDOW) {
+    state.latencies_ns.push_back(ns);
+  }
+  else {
+    state.latencies_ns[state.requests % LATENCY_WINDOW] = ns;
+  }
+  state.requests++;
+  state.frames += frame;
+  state.bad_requests += bad;
+}
+
+static double percentile(std::vector<uint64_t> samples, double fraction) {
+  if (samples.empty()) {
+    return 0.0;
+  }
+  size_t rank = std::min(samples.size() - 1, size_t(fraction * samples.size()));
+  std::nth_element(samples.begin(), samples.begin() + rank, samples.end());
+  return double(samples[rank]);
+}
+
+static std::string stats_json(daemon_state& state) {
+  std::vector<uint64_t> samples;
+  uint64_t requests, frames, bad;
+  {
+    std::lock_guard<std::mutex> lock(state.metrics_mutex);
+    samples = state.latencies_ns;
+    requests = state.requests;
+    frames = state.frames;
+    bad = state.bad_requests;
+  }
+  std::chrono::duration<double> uptime = std::chrono::steady_clock::now() - state.start;
+  std::ostringstream json;
+  json << "{\"requests\":" << requests
+       << ",\"frames\":" << frames
+       << ",\"bad_requests\":" << bad
+       << ",\"uptime_s\":" << uptime.count()
+       << ",\"requests_per_s\":" << requests / uptime.count()
+       << ",\"frames_per_s\":" << frames / uptime.count()
+       << ",\"p50_us\":" << percentile(samples, 0.50) / 1e3
+       << ",\"p99_us\":" << percentile(samples, 0.99) / 1e3
+       << ",\"palette_hit_rate\":" << state.palettes.hit_rate()
+       << ",\"iteration_hit_rate\":" << state.iterations.hit_rate()
+       << ",\"width\":" << state.width
+       << ",\"height\":" << state.height << "}";
+  return json.str();
+}
+
+static std::shared_ptr<const std::vector<colour>> get_palette(daemon_state& state, const test_case& t) {
+  palette_key key = {t.colours[0], t.colours[1], t.colours[2], t.colours[3], t.colours[4], t.colours[5], t.max_iterations};
+  std::shared_ptr<const std::vector<colour>> palette = state.palettes.get(key);
+  if (palette == nullptr) {
+    std::vector<colour> unique_colours = {};
+    std::vector<colour> interp_points(t.colours, t.colours + 6);
+    std::shared_ptr<std::vector<colour>> colour_map = std::make_shared<std::vector<colour>>();
+    generate_unique_colours(unique_colours, interp_points);
+    generate_colour_map(t.max_iterations, unique_colours, *colour_map);
+    state.palettes.put(key, colour_map);
+    palette = colour_map;
+  }
+  return palette;
+}
+
+static std::shared_ptr<const std::vector<uint16_t>> get_iterations(daemon_state& state, const test_case& t) {
+  coord_step c = center_coords(t.center_x, t.center_y, t.zoom, state.width, state.height);
+  geometry_key key(c.x, c.y, c.step, t.max_iterations);
+  std::shared_ptr<const std::vector<uint16_t>> counts = state.iterations.get(key);
+  if (counts == nullptr) {
+    // two clients asking for the same new view at once may both render it, which is harmless
+    std::shared_ptr<std::vector<uint16_t>> buffer = std::make_shared<std::vector<uint16_t>>(size_t(state.width) * state.height);
+    iterateMandelbrotParallel(c.x, c.y, c.step, t.max_iterations, buffer->data(), state.width, state.height, state.width, state.frame_threads);
+    state.iterations.put(key, buffer);
+    counts = buffer;
+  }
+  return counts;
+}
+
+static bool write_all(int fd, const void* data, size_t bytes) {
+  const char* p = static_cast<const char*>(data);
+  while (bytes > 0) {
+    ssize_t written = write(fd, p, bytes);
+    if (written <= 0) {
+      return false;
+    }
+    p += written;
+    bytes -= written;
+  }
+  return true;
+}
+
+// answer one request line, false if the client has gone away
+static bool serve_request(daemon_state& state, int fd, const std::string& line, std::vector<colour>& framebuffer) {
+  auto start = std::chrono::steady_clock::now();
+  daemon_reply_header header = {};
+  header.magic = DAEMON_REPLY_MAGIC;
+  const void* payload = nullptr;
+  std::string stats;
+  std::shared_ptr<const std::vector<uint16_t>> counts;
+
+  std::string request = line;
+  std::string keyword;
+  std::istringstream(request) >> keyword;
+  bool frame = false;
+  if (keyword == "STATS") {
+    stats = stats_json(state);
+    header.format = DAEMON_FORMAT_STATS;
+    header.payload_bytes = stats.size();
+    payload = stats.data();
+  }
+  else {
+    header.format = DAEMON_FORMAT_RGB565;
+    if (keyword == "ITER" || keyword == "RGB565") {
+      header.format = keyword == "ITER" ? DAEMON_FORMAT_ITERATIONS : DAEMON_FORMAT_RGB565;
+      request = request.substr(request.find(keyword) + keyword.size());
+    }
+    test_case t = {};
+    if (parse_test_case(request, t)) {
+      frame = true;
+      counts = get_iterations(state, t);
+      header.width = state.width;
+      header.height = state.height;
+      header.payload_bytes = counts->size() * sizeof(uint16_t);
+      if (header.format == DAEMON_FORMAT_ITERATIONS) {
+        payload = counts->data();
+      }
+      else {
+        std::shared_ptr<const std::vector<colour>> palette = get_palette(state, t);
+        colouriseMandelbrot(counts->data(), state.width, framebuffer.data(), state.width, state.width, state.height, t.max_iterations, *palette);
+        payload = framebuffer.data();
+      }
+    }
+    else {
+      header.status = DAEMON_BAD_REQUEST;
+    }
+  }
+
+  header.service_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+  bool ok = write_all(fd, &header, sizeof(header)) && write_all(fd, payload, header.payload_bytes);
+  uint64_t latency = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+  record_latency(state, latency, frame, header.status != DAEMON_OK);
+  return ok;
+}
+
+static void serve_connection(daemon_state& state, int fd) {
+  std::vector<colour> framebuffer(size_t(state.width) * state.height);
+  std::string pending;
+  char buffer[4096];
+  while (!stopping) {
+    ssize_t received = read(fd, buffer, sizeof(buffer));
+    if (received <= 0) {
+      break;
+    }
+    pending.append(buffer, received);
+    size_t end;
+    bool open = true;
+    while (open && (end = pending.find('\n')) != std::string::npos) {
+      std::string line = pending.substr(0, end);
+      pending.erase(0, end + 1);
+      if (line.find_first_not_of(" \t\r") != std::string::npos) {
+        open = serve_request(state, fd, line, framebuffer);
+      }
+    }
+    if (!open || pending.size() > DAEMON_MAX_REQUEST_LINE) {
+      break;
+    }
+  }
+  close(fd);
+}
+
+int main(int argc, char** argv)
+{
+  std::string socket_path = DAEMON_DEFAULT_SOCKET;
+  int width = DEFAULT_XSIZE;
+  int height = DEFAULT_YSIZE;
+  int frame_threads = std::max(1u, std::thread::hardware_concurrency());
+  int iteration_capacity = 16;
+  int palette_capacity = 64;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--socket") == 0 && i + 1 < argc) {
+      socket_path = argv[++i];
+    }
+    else if (strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+      if (sscanf(argv[++i], "%dx%d", &width, &height) != 2 || width < 1 || height < 1 || width > MAX_XSIZE || height > MAX_YSIZE) {
+        fprintf(stderr, "size must be between 1x1 and %dx%d\n", MAX_XSIZE, MAX_YSIZE);
+        return 1;
+      }
+    }
+    else if (strcmp(argv[i], "--frame-threads") == 0 && i + 1 < argc) {
+      frame_threads = std::max(1, atoi(argv[++i]));
+    }
+    else if (strcmp(argv[i], "--iteration-cache") == 0 && i + 1 < argc) {
+      iteration_capacity = std::max(0, atoi(argv[++i]));
+    }
+    else if (strcmp(argv[i], "--palette-cache") == 0 && i + 1 < argc) {
+      palette_capacity = std::max(0, atoi(argv[++i]));
+    }
+  }
+
+  daemon_state state(palette_capacity, iteration_capacity);
+  state.width = width;
+  state.height = height;
+  state.frame_threads = frame_threads;
+
+  int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+  struct sockaddr_un address = {};
+  address.sun_family = AF_UNIX;
+  if (listener < 0 || socket_path.size() >= sizeof(address.sun_path)) {
+    fprintf(stderr, "could not create socket %s\n", socket_path.c_str());
+    return 1;
+  }
+  strcpy(address.sun_path, socket_path.c_str());
+  unlink(socket_path.c_str());
+  if (bind(listener, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) != 0 || listen(listener, 16) != 0) {
+    fprintf(stderr, "could not listen on %s\n", socket_path.c_str());
+    return 1;
+  }
+
+  signal(SIGPIPE, SIG_IGN);
+  signal(SIGINT, handle_signal);
+  signal(SIGTERM, handle_signal);
+  fprintf(stderr, "serving %dx%d frames on %s\n", width, height, socket_path.c_str());
+
+  while (!stopping) {
+    struct pollfd waiting = {listener, POLLIN, 0};
+    if (poll(&waiting, 1, 200) <= 0) {
+      continue;
+    }
+    int fd = accept(listener, nullptr, nullptr);
+    if (fd >= 0) {
+      // connections blocked in read are not woken on shutdown, so they are left to process exit
+      std::thread(serve_connection, std::ref(state), fd).detach();
+    }
+  }
+
+  close(listener);
+  unlink(socket_path.c_str());
+  fprintf(stderr, "%s\n", stats_json(state).c_str());
+}
@@ -0,0 +1,52 @@
+/* ----------------------------------------------------------
+**
+**
+**   Render daemon protocol
+**
+**   Requests are text lines sent over a UNIX stream socket:
+**     [RGB565|ITER] <input_file.txt line>
+**     STATS
+**   A bare input line asks for an RGB565 frame. Each request
+**   gets a daemon_reply_header followed by payload_bytes of
+**   data: width * height RGB565 colours or iteration counts
+**   (uint16, row-major, native endian) for frames, or a JSON
+**   object for STATS. A connection may carry any number of
+**   requests.
+**
+**   Luke Rule
+**
+---------------------------------------------------------- */
+#ifndef RENDER_PROTOCOL_H
+#define RENDER_PROTOCOL_H
+
+#include <stdint.h>
+
+#define DAEMON_DEFAULT_SOCKET "/tmp/mandelbrot.sock"
+// "MBRD"
+#define DAEMON_REPLY_MAGIC 0x4d425244
+// longest request line the daemon buffers; a client sending more without a newline is dropped
+#define DAEMON_MAX_REQUEST_LINE 1024
+
+enum daemon_status {
+  DAEMON_OK = 0,
+  DAEMON_BAD_REQUEST = 1
+};
+
+enum daemon_format {
+  DAEMON_FORMAT_RGB565 = 0,
+  DAEMON_FORMAT_ITERATIONS = 1,
+  DAEMON_FORMAT_STATS = 2
+};
+
+struct daemon_reply_header {
+  uint32_t magic;
+  uint32_t status;
+  uint32_t format;
+  uint32_t width;
+  uint32_t height;
+  uint32_t payload_bytes;
+  // time spent inside the daemon on this request
+  uint64_t service_ns;
+};
+
+#endif
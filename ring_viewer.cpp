@@ -0,0 +1,84 @@
+/* ----------------------------------------------------------
+**
+**
+**   Framebuffer ring consumer
+**
+**   Maps the renderer's shared-memory ring and either saves the
+**   latest frame as a PPM, or streams every new frame to stdout
+**   as raw RGB24 (e.g. into ffplay or an encoder)
+**
+**   usage: ring_viewer <ring name> [--snapshot file.ppm]
+**
+**   Luke Rule
+**
+---------------------------------------------------------- */
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <vector>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "mandelbrot_renderer.h"
+#include "framebuffer_ring.h"
+
+// expand RGB565 to RGB24 straight out of the mapped slot
+void convert_frame(const ring_frame_view& view, std::vector<uint8_t>& rgb) {
+  size_t pixels = size_t(view.meta.width) * view.meta.height;
+  rgb.resize(pixels * 3);
+  for (size_t i = 0; i < pixels; i++) {
+    uint16_t c = view.pixels[i];
+    rgb[i * 3] = RED(c) << 3;
+    rgb[i * 3 + 1] = GREEN(c) << 2;
+    rgb[i * 3 + 2] = BLUE(c) << 3;
+  }
+}
+
+int main(int argc, char** argv)
+{
+  if (argc < 2) {
+    std::cerr << "usage: ring_viewer <ring name> [--snapshot file.ppm]\n";
+    return 1;
+  }
+  std::string snapshot;
+  if (argc >= 4 && strcmp(argv[2], "--snapshot") == 0) {
+    snapshot = argv[3];
+  }
+
+  framebuffer_ring ring;
+  if (!ring_open(ring, argv[1])) {
+    std::cerr << "could not open framebuffer ring " << argv[1] << "\n";
+    return 1;
+  }
+
+  std::vector<uint8_t> rgb;
+  uint64_t last_frame = 0;
+  while (true) {
+    ring_frame_view view;
+    if (!ring_acquire_latest(ring, view) || view.meta.frame_number == last_frame) {
+      usleep(1000);
+      continue;
+    }
+    convert_frame(view, rgb);
+    // the writer lapped us while converting, try again with a newer frame
+    if (!ring_frame_valid(view)) {
+      continue;
+    }
+    last_frame = view.meta.frame_number;
+
+    if (!snapshot.empty()) {
+      std::ofstream ofs(snapshot, std::ios::out | std::ios::binary);
+      ofs << "P6\n" << view.meta.width << " " << view.meta.height << "\n255\n";
+      ofs.write(reinterpret_cast<const char*>(rgb.data()), rgb.size());
+      break;
+    }
+    if (fwrite(rgb.data(), 1, rgb.size(), stdout) != rgb.size()) {
+      break;
+    }
+    fflush(stdout);
+  }
+
+  ring_close(ring);
+}
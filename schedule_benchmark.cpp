@@ -0,0 +1,140 @@
+/* ----------------------------------------------------------
+**
+**
+**   Tile scheduling benchmark
+**
+**   Compares tiles claimed in scanline order with tiles claimed
+**   longest first after a low-resolution estimate pass. Reports
+**   frame latency percentiles, thread imbalance and the makespan
+**   each order would have on --simulate N threads, using the
+**   measured per-tile times.
+**
+**   usage: schedule_benchmark [--threads N] [--reps R] [--size WxH]
+**                             [--simulate N]
+**
+**   Luke Rule
+**
+---------------------------------------------------------- */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <thread>
+#include <algorithm>
+
+#include "mandelbrot_renderer.h"
+#include "tile_scheduler.h"
+
+struct schedule_view {
+  const char* name;
+  double x;
+  double y;
+  int zoom;
+  int max_iterations;
+};
+
+struct schedule_result {
+  double p50_ms;
+  double p99_ms;
+  double imbalance_ms;     // mean over reps of the busiest minus the idlest thread
+  double simulated_ms;     // makespan on simulate threads from the fastest time of each tile
+};
+
+static fixed_32 to_fixed(double value) {
+  return fixed_32(int64_t(value * (1 << FRAC_BITS)));
+}
+
+using schedule_kernel = void (*)(fixed_32, fixed_32, fixed_32, int, uint16_t*, int, int, size_t, int, tile_schedule_stats*);
+
+static schedule_result run(schedule_kernel kernel, const coord_step& c, int max_iterations, uint16_t* buffer, int width, int height, size_t stride, int threads, int reps, int simulate) {
+  std::vector<double> latencies;
+  schedule_result result = {0.0, 0.0, 0.0, 0.0};
+  // fastest time of each tile over the reps, so one preempted tile does not decide the makespan
+  std::vector<float> tile_seconds;
+  std::vector<int> order;
+  double estimate_work_seconds = 1e30;
+  for (int r = 0; r < reps; r++) {
+    tile_schedule_stats stats;
+    kernel(c.x, c.y, c.step, max_iterations, buffer, width, height, stride, threads, &stats);
+    latencies.push_back(stats.render_seconds * 1e3);
+    auto busy = std::minmax_element(stats.thread_seconds.begin(), stats.thread_seconds.end());
+    result.imbalance_ms += (*busy.second - *busy.first) * 1e3 / reps;
+    if (r == 0) {
+      tile_seconds = stats.tile_seconds;
+    }
+    for (size_t t = 0; t < tile_seconds.size(); t++) {
+      tile_seconds[t] = std::min(tile_seconds[t], stats.tile_seconds[t]);
+    }
+    order = stats.order;
+    estimate_work_seconds = std::min(estimate_work_seconds, stats.estimate_work_seconds);
+  }
+  // the estimate pass's work split across the simulated threads as well; its wall time would
+  // count waiting for a core when this run has more threads than the host has cores
+  result.simulated_ms = (simulated_makespan(order, tile_seconds, simulate) + estimate_work_seconds / simulate) * 1e3;
+  std::sort(latencies.begin(), latencies.end());
+  result.p50_ms = latencies[latencies.size() / 2];
+  result.p99_ms = latencies[std::min(latencies.size() - 1, latencies.size() * 99 / 100)];
+  return result;
+}
+
+int main(int argc, char** argv)
+{
+  int threads = std::max(1u, std::thread::hardware_concurrency());
+  int reps = 9;
+  int width = DEFAULT_XSIZE;
+  int height = DEFAULT_YSIZE;
+  int simulate = 8;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+      threads = std::max(1, atoi(argv[++i]));
+    }
+    else if (strcmp(argv[i], "--reps") == 0 && i + 1 < argc) {
+      reps = std::max(1, atoi(argv[++i]));
+    }
+    else if (strcmp(argv[i], "--simulate") == 0 && i + 1 < argc) {
+      simulate = std::max(1, atoi(argv[++i]));
+    }
+    else if (strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+      if (sscanf(argv[++i], "%dx%d", &width, &height) != 2 || width < 1 || height < 1 || width > MAX_XSIZE || height > MAX_YSIZE) {
+        fprintf(stderr, "bad size\n");
+        return 1;
+      }
+    }
+  }
+
+  const schedule_view views[] = {
+    {"full", -0.5, 0.0, 0, 511},
+    {"cardioid_edge", -0.7467, 0.163, 6, 511},
+    {"minibrot", -1.766, 0.0, 5, 511},
+    {"seahorse", -0.745, 0.186, 6, 511},
+    {"elephant", 0.273, 0.007, 7, 511},
+    {"very_zoomed", 0.001643721971153, -0.822467633298876, 8, 511},
+  };
+
+  const size_t row_align = BUFFER_ALIGNMENT / sizeof(uint16_t);
+  size_t stride = (size_t(width) + row_align - 1) & ~(row_align - 1);
+  aligned_buffer<uint16_t> reference;
+  aligned_buffer<uint16_t> buffer;
+  reference.reserve(stride * height);
+  buffer.reserve(stride * height);
+
+  printf("%dx%d, %d threads, %d reps, makespan simulated on %d threads\n\n", width, height, threads, reps, simulate);
+  printf("%-14s %-9s %9s %9s %12s %13s\n", "view", "order", "p50 ms", "p99 ms", "imbalance ms", "simulated ms");
+  for (const schedule_view& v : views) {
+    coord_step c = center_coords(to_fixed(v.x), to_fixed(v.y), v.zoom, width, height);
+    iterateMandelbrotParallel(c.x, c.y, c.step, v.max_iterations, reference.data(), width, height, stride, threads);
+
+    const char* names[2] = {"scanline", "lpt"};
+    schedule_kernel kernels[2] = {iterateMandelbrotScanlineTiles, iterateMandelbrotLPT};
+    for (int k = 0; k < 2; k++) {
+      schedule_result r = run(kernels[k], c, v.max_iterations, buffer.data(), width, height, stride, threads, reps, simulate);
+      for (int y = 0; y < height; y++) {
+        if (memcmp(reference.data() + y * stride, buffer.data() + y * stride, width * sizeof(uint16_t)) != 0) {
+          fprintf(stderr, "%s order differs from the row render on row %d\n", names[k], y);
+          return 1;
+        }
+      }
+      printf("%-14s %-9s %9.3f %9.3f %12.3f %13.3f\n", v.name, names[k], r.p50_ms, r.p99_ms, r.imbalance_ms, r.simulated_ms);
+    }
+  }
+}
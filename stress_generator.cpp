@@ -0,0 +1,343 @@
+/* ----------------------------------------------------------
+**
+**
+**   Stress suite generator
+**
+**   Writes test cases in the input_file.txt format, or as a
+**   binary batch file (batch_render.h) with --binary. Cases are
+**   drawn from the families of test_input_generator.py with
+**   configurable weights, from a seeded RNG so a seed always
+**   gives the same suite. --standard writes the same sequence
+**   as the Python script instead: every fixed case in order,
+**   with random windows filling up to 25.
+**
+**   usage: stress_generator [--cases N] [--seed S] [--binary]
+**                           [--weights family=w,...] [--standard]
+**                           [--output file|-]
+**
+**   families: windows q329 random colours zooms ack iterations
+**
+**   Luke Rule
+**
+---------------------------------------------------------- */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+
+#include "batch_render.h"
+#include "xoshiro.h"
+
+enum case_family { WINDOWS, Q329, RANDOM, COLOURS, ZOOMS, ACK, ITERATIONS, FAMILY_COUNT };
+static const char* family_names[FAMILY_COUNT] = {"windows", "q329", "random", "colours", "zooms", "ack", "iterations"};
+// by default each family is as common as in the Python script's 40 cases
+static const int default_weights[FAMILY_COUNT] = {15, 4, 6, 4, 4, 1, 6};
+
+struct window {
+  double x;
+  double y;
+  int zoom;
+};
+
+// interesting windows and the edges of the set
+static const window windows[] = {
+  {-0.5, 0.0, 0},                                 // full view
+  {-0.7467, 0.163, 6},                            // edge of main cardioid
+  {-0.749, 0.07, 5},                              // valley between main cardioid and period-2 bulb
+  {-1.26, -0.07, 5},                              // valley between period-2 and period-3 bulbs
+  {-1.766, 0, 5},                                 // repeated smaller mandelbrot
+  {-0.2, -0.865, 3},                              // outer branches
+  {0.001643721971153, -0.822467633298876, 8},     // very zoomed in
+  {0.285, 0.0, 5},                                // right valley
+  {-0.745, 0.186, 6},                             // seahorse valley
+  {0.273, 0.007, 7},                              // elephant valley
+  {2.0, 1.5, 0},                                  // edges of the set
+  {-2.0, -1.5, 0},
+  {0.0, 1.5, 0},
+  {0.0, -1.5, 0},
+  {0.0, 0.0, 0},                                  // origin
+};
+
+// ends of the Q3.29 range
+static const window q329_windows[] = {
+  {3.999999, 0.0, 1},
+  {-4.0, 0.0, 1},
+  {0.0, 3.999999, 1},
+  {0.0, -4.0, 1},
+};
+
+static const colour colour_sets[4][6] = {
+  {0x5959, 0x5959, 0x5959, 0x5959, 0x5959, 0x5959},   // all colours the same
+  {0x0001, 0x0002, 0x0003, 0x0004, 0x0005, 0x0006},   // colours close together
+  {0xF800, 0x07E0, 0x001F, 0xFC00, 0x03FF, 0xF81F},   // close together but rgb all different
+  {0xF810, 0x07F0, 0x0010, 0xFC1F, 0x03E0, 0xF80F},   // far apart but rgb all different
+};
+
+static const double edge_x = 0.001643721971153;
+static const double edge_y = -0.822467633298876;
+static const int edge_zooms[] = {0, 10, 15, -5};
+static const int edge_iterations[] = {0, 16, 40, -50, 550, 511};
+
+static uint32_t float_to_q3_29(double value) {
+  return uint32_t(int64_t(value * (1 << FRAC_BITS)) & 0xffffffff);
+}
+
+static batch_record make_record(xoshiro256& rng, double x, double y, int zoom, int max_iterations, const colour* colours = nullptr, int ack_mode = 0) {
+  batch_record r;
+  r.center_x = float_to_q3_29(x);
+  r.center_y = float_to_q3_29(y);
+  r.zoom = zoom;
+  r.max_iterations = max_iterations;
+  for (int i = 0; i < 6; i++) {
+    r.colours[i] = colours != nullptr ? colours[i] : colour(rng.between(1, 0xffff));
+  }
+  r.ack_mode = ack_mode;
+  return r;
+}
+
+// a window centred off the main cardioid, the period-2 bulb and the small circle at -0.5, as in the Python script
+static batch_record random_window(xoshiro256& rng) {
+  while (true) {
+    double x = rng.uniform(-1.5, 0.5);
+    double y = rng.uniform(-1.0, 1.0);
+    double q = (x - 0.25) * (x - 0.25) + y * y;
+    if (q * (q + x - 0.25) <= 0.25 * y * y) {
+      continue;
+    }
+    if ((x + 1) * (x + 1) + y * y <= 0.25 * 0.25) {
+      continue;
+    }
+    if ((x + 0.5) * (x + 0.5) + y * y <= (1.0 / 8) * (1.0 / 8)) {
+      continue;
+    }
+    return make_record(rng, x, y, rng.between(0, 10), 180);
+  }
+}
+
+// member of a family; index picks it, or -1 for a random one
+static batch_record family_case(xoshiro256& rng, int family, int index) {
+  auto pick = [&](int count) { return index >= 0 ? index % count : int(rng.below(count)); };
+  switch (family) {
+    case WINDOWS: {
+      const window& w = windows[pick(sizeof(windows) / sizeof(windows[0]))];
+      return make_record(rng, w.x, w.y, w.zoom, 180);
+    }
+    case Q329: {
+      const window& w = q329_windows[pick(sizeof(q329_windows) / sizeof(q329_windows[0]))];
+      return make_record(rng, w.x, w.y, w.zoom, 180);
+    }
+    case RANDOM:
+      return random_window(rng);
+    case COLOURS:
+      return make_record(rng, 0.0, 0.0, 1, 128, colour_sets[pick(4)]);
+    case ZOOMS:
+      return make_record(rng, edge_x, edge_y, edge_zooms[pick(4)], 128);
+    case ACK:
+      // not instant ack
+      return make_record(rng, edge_x, edge_y, 5, 256, nullptr, 2);
+    default:
+      return make_record(rng, edge_x, edge_y, 0, edge_iterations[pick(6)]);
+  }
+}
+
+// the Python script's sequence
+static std::vector<batch_record> standard_suite(xoshiro256& rng) {
+  std::vector<batch_record> suite;
+  for (int i = 0; i < int(sizeof(windows) / sizeof(windows[0])); i++) {
+    suite.push_back(family_case(rng, WINDOWS, i));
+  }
+  for (int i = 0; i < 4; i++) {
+    suite.push_back(family_case(rng, Q329, i));
+  }
+  while (suite.size() < 25) {
+    suite.push_back(random_window(rng));
+  }
+  for (int family : {COLOURS, ZOOMS, ACK, ITERATIONS}) {
+    int members = family == ACK ? 1 : family == ITERATIONS ? 6 : 4;
+    for (int i = 0; i < members; i++) {
+      suite.push_back(family_case(rng, family, i));
+    }
+  }
+  return suite;
+}
+
+// snprintf is most of the time for text suites, so fields are formatted by hand, each followed by a space
+static char* put_hex(char* p, uint32_t value, int digits) {
+  *p++ = '0';
+  *p++ = 'x';
+  for (int d = digits - 1; d >= 0; d--) {
+    *p++ = "0123456789abcdef"[(value >> (4 * d)) & 0xf];
+  }
+  *p++ = ' ';
+  return p;
+}
+
+static char* put_int(char* p, int value) {
+  char digits[12];
+  int n = 0;
+  unsigned magnitude = value < 0 ? 0u - unsigned(value) : unsigned(value);
+  do {
+    digits[n++] = '0' + magnitude % 10;
+    magnitude /= 10;
+  } while (magnitude != 0);
+  if (value < 0) {
+    *p++ = '-';
+  }
+  while (n > 0) {
+    *p++ = digits[--n];
+  }
+  *p++ = ' ';
+  return p;
+}
+
+struct suite_writer {
+  FILE* file;
+  bool binary;
+  std::vector<char> buffer;
+  size_t used = 0;
+  uint64_t cases = 0;
+  uint64_t bytes = 0;
+  bool ok = true;
+
+  suite_writer(FILE* f, bool b) : file(f), binary(b), buffer(1 << 20) {
+    if (binary) {
+      uint32_t magic = BATCH_FILE_MAGIC;
+      append(&magic, sizeof(magic));
+    }
+  }
+
+  void append(const void* data, size_t length) {
+    if (used + length > buffer.size()) {
+      flush();
+    }
+    memcpy(buffer.data() + used, data, length);
+    used += length;
+  }
+
+  void write(const batch_record& r) {
+    if (binary) {
+      append(&r, sizeof(r));
+    }
+    else {
+      // no newline after the last line: the testbench's $feof loop would read an empty case
+      char line[128];
+      char* p = line;
+      if (cases != 0) {
+        *p++ = '\n';
+      }
+      p = put_hex(p, r.center_x, 8);
+      p = put_hex(p, r.center_y, 8);
+      p = put_int(p, r.zoom);
+      p = put_int(p, r.max_iterations);
+      for (int i = 0; i < 6; i++) {
+        p = put_hex(p, r.colours[i], 4);
+      }
+      p = put_int(p, r.ack_mode) - 1;
+      append(line, p - line);
+    }
+    cases++;
+  }
+
+  bool flush() {
+    ok = fwrite(buffer.data(), 1, used, file) == used && ok;
+    bytes += used;
+    used = 0;
+    return ok;
+  }
+};
+
+int main(int argc, char** argv)
+{
+  uint64_t cases = 1000000;
+  uint64_t seed = 1;
+  bool binary = false;
+  bool standard = false;
+  std::string output = "input_file.txt";
+  int weights[FAMILY_COUNT];
+  std::copy(default_weights, default_weights + FAMILY_COUNT, weights);
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--cases") == 0 && i + 1 < argc) {
+      cases = strtoull(argv[++i], nullptr, 10);
+    }
+    else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+      seed = strtoull(argv[++i], nullptr, 0);
+    }
+    else if (strcmp(argv[i], "--binary") == 0) {
+      binary = true;
+    }
+    else if (strcmp(argv[i], "--standard") == 0) {
+      standard = true;
+    }
+    else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+      output = argv[++i];
+    }
+    else if (strcmp(argv[i], "--weights") == 0 && i + 1 < argc) {
+      // e.g. random=90,windows=10; families not named keep their weight
+      std::string list = argv[++i];
+      size_t start = 0;
+      while (start < list.size()) {
+        size_t comma = std::min(list.find(',', start), list.size());
+        std::string item = list.substr(start, comma - start);
+        size_t equals = item.find('=');
+        int family = 0;
+        while (family < FAMILY_COUNT && (equals == std::string::npos || item.compare(0, equals, family_names[family]) != 0)) {
+          family++;
+        }
+        if (family == FAMILY_COUNT || atoi(item.c_str() + equals + 1) < 0) {
+          fprintf(stderr, "bad weight %s, expected family=weight with family one of windows q329 random colours zooms ack iterations\n", item.c_str());
+          return 1;
+        }
+        weights[family] = atoi(item.c_str() + equals + 1);
+        start = comma + 1;
+      }
+    }
+  }
+  int weight_total = 0;
+  for (int f = 0; f < FAMILY_COUNT; f++) {
+    weight_total += weights[f];
+  }
+  if (weight_total == 0) {
+    fprintf(stderr, "all weights are zero\n");
+    return 1;
+  }
+
+  FILE* file = output == "-" ? stdout : fopen(output.c_str(), binary ? "wb" : "w");
+  if (file == nullptr) {
+    fprintf(stderr, "could not open %s\n", output.c_str());
+    return 1;
+  }
+  auto start = std::chrono::steady_clock::now();
+  xoshiro256 rng(seed);
+  suite_writer writer(file, binary);
+  if (standard) {
+    for (const batch_record& r : standard_suite(rng)) {
+      writer.write(r);
+    }
+  }
+  else {
+    for (uint64_t n = 0; n < cases; n++) {
+      int pick = rng.below(weight_total);
+      int family = 0;
+      while (pick >= weights[family]) {
+        pick -= weights[family];
+        family++;
+      }
+      writer.write(family_case(rng, family, -1));
+    }
+  }
+  bool ok = writer.flush();
+  if (file != stdout) {
+    ok = fclose(file) == 0 && ok;
+  }
+  if (!ok) {
+    fprintf(stderr, "write to %s failed\n", output.c_str());
+    return 1;
+  }
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  fprintf(stderr, "%llu cases, %.1f MB in %.3f s (%.0f MB/s), seed %llu\n", (unsigned long long)writer.cases, writer.bytes / 1e6, seconds,
+          writer.bytes / 1e6 / seconds, (unsigned long long)seed);
+  return 0;
+}
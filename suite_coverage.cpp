@@ -0,0 +1,161 @@
+/* ----------------------------------------------------------
+**
+**
+**   Coverage features of test cases, and suite minimisation
+**
+**   Luke Rule
+**
+---------------------------------------------------------- */
+#include "suite_coverage.h"
+
+#include <limits.h>
+#include <algorithm>
+
+#include "cost_predictor.h"
+
+std::string coverage_feature_name(int feature) {
+  static const char* names[] = {
+    "colour_map_sample", "colour_map_repeat", "colour_flat_segment", "spread_identity", "spread_in_range", "spread_clamp",
+    "zoom_trap_high", "zoom_trap_low", "iterations_trap_low", "iterations_trap_high", "iterations_limit", "ack_instant",
+    "ack_delayed", "position_wrap",
+  };
+  if (feature >= COVER_HISTOGRAM_BIN) {
+    return "histogram_" + std::to_string(feature - COVER_HISTOGRAM_BIN);
+  }
+  if (feature >= COVER_ZOOM_LEVEL) {
+    return "zoom_" + std::to_string(feature - COVER_ZOOM_LEVEL);
+  }
+  return names[feature];
+}
+
+// the frame's first and last positions in 64 bits, before the registers wrap them
+static bool wraps(const test_case& t, int width, int height) {
+  int zoom = t.zoom > MAX_ZOOM || t.zoom < 0 ? 0 : t.zoom;
+  int64_t step = int64_t(BASE_INCREMENT_AMOUNT) << (MAX_ZOOM - zoom);
+  int64_t x_first = int64_t(fixed_32(t.center_x)) - (width >> 1) * step;
+  int64_t y_first = int64_t(fixed_32(t.center_y)) + (height >> 1) * step;
+  int64_t x_last = x_first + (width - 1) * step;
+  int64_t y_last = y_first - (height - 1) * step;
+  return x_first < INT32_MIN || x_last > INT32_MAX || y_first > INT32_MAX || y_last < INT32_MIN;
+}
+
+std::vector<case_coverage> measure_coverage(const std::vector<test_case>& cases, int width, int height, int threads) {
+  std::vector<case_coverage> coverage(cases.size());
+  std::vector<geometry_group> groups = plan_geometry_groups(cases, true, width, height);
+  std::vector<uint16_t> iterations(size_t(width) * height);
+  for (const geometry_group& group : groups) {
+    iterateMandelbrotParallel(group.c.x, group.c.y, group.c.step, group.max_iterations, iterations.data(), width, height, width, threads);
+    // which counts occur is all the colour path depends on
+    std::vector<uint32_t> counts(group.max_iterations + 1);
+    uint64_t total = 0;
+    for (uint16_t n : iterations) {
+      counts[n]++;
+      total += n;
+    }
+    uint64_t cycles = hardware_cycles(total, group.max_iterations, width, height);
+
+    for (int index : group.cases) {
+      const test_case& t = cases[index];
+      coverage_set& f = coverage[index].features;
+      coverage[index].hardware_cycles = cycles;
+      int max_iterations = t.max_iterations;
+
+      std::vector<colour> unique_colours;
+      std::vector<colour> interp_points(t.colours, t.colours + 6);
+      generate_unique_colours(unique_colours, interp_points);
+      f[int(unique_colours.size()) > max_iterations ? COVER_COLOUR_MAP_SAMPLE : COVER_COLOUR_MAP_REPEAT] = true;
+      for (int i = 0; i < 5; i++) {
+        if (t.colours[i] == t.colours[i + 1]) {
+          f[COVER_COLOUR_FLAT_SEGMENT] = true;
+        }
+      }
+      // the branches of get_spread_colour_index taken by the escaped pixels
+      int m = max_iterations;
+      int spread = (m >> 4) - (m >> 5) - (m >> 6) - (m >> 10);
+      for (int n = 0; n < m; n++) {
+        if (counts[n] == 0) {
+          continue;
+        }
+        if (m < 16) {
+          f[COVER_SPREAD_IDENTITY] = true;
+        }
+        else {
+          f[n * spread < m ? COVER_SPREAD_IN_RANGE : COVER_SPREAD_CLAMP] = true;
+        }
+      }
+
+      if (t.zoom > MAX_ZOOM) {
+        f[COVER_ZOOM_TRAP_HIGH] = true;
+      }
+      else if (t.zoom < 0) {
+        f[COVER_ZOOM_TRAP_LOW] = true;
+      }
+      f[COVER_ZOOM_LEVEL + (t.zoom > MAX_ZOOM || t.zoom < 0 ? 0 : t.zoom)] = true;
+      if (t.requested_max_iterations <= 0) {
+        f[COVER_ITERATIONS_TRAP_LOW] = true;
+      }
+      else if (t.requested_max_iterations > MAX_ITERATIONS) {
+        f[COVER_ITERATIONS_TRAP_HIGH] = true;
+      }
+      else if (t.requested_max_iterations == MAX_ITERATIONS) {
+        f[COVER_ITERATIONS_LIMIT] = true;
+      }
+      f[t.ack_mode == 0 ? COVER_ACK_INSTANT : COVER_ACK_DELAYED] = true;
+      f[COVER_POSITION_WRAP] = wraps(t, width, height);
+      for (int n = 0; n <= max_iterations; n++) {
+        if (counts[n] != 0) {
+          f[COVER_HISTOGRAM_BIN + size_t(n) * STATS_HISTOGRAM_BINS / (max_iterations + 1)] = true;
+        }
+      }
+    }
+  }
+  return coverage;
+}
+
+std::vector<int> minimise_suite(const std::vector<case_coverage>& coverage) {
+  coverage_set wanted;
+  for (const case_coverage& c : coverage) {
+    wanted |= c.features;
+  }
+  std::vector<int> chosen;
+  coverage_set covered;
+  while (covered != wanted) {
+    int best = -1;
+    double best_score = 0.0;
+    for (size_t i = 0; i < coverage.size(); i++) {
+      size_t gain = (coverage[i].features & ~covered).count();
+      double score = gain / double(coverage[i].hardware_cycles + 1);
+      if (gain > 0 && score > best_score) {
+        best = i;
+        best_score = score;
+      }
+    }
+    chosen.push_back(best);
+    covered |= coverage[best].features;
+  }
+
+  // a case picked early can be made redundant by later picks: drop the dearest such cases first
+  std::vector<int> times_covered(COVER_FEATURE_COUNT);
+  for (int i : chosen) {
+    for (int f = 0; f < COVER_FEATURE_COUNT; f++) {
+      times_covered[f] += coverage[i].features[f];
+    }
+  }
+  std::sort(chosen.begin(), chosen.end(), [&](int a, int b) { return coverage[a].hardware_cycles > coverage[b].hardware_cycles; });
+  std::vector<int> kept;
+  for (int i : chosen) {
+    bool needed = false;
+    for (int f = 0; f < COVER_FEATURE_COUNT && !needed; f++) {
+      needed = coverage[i].features[f] && times_covered[f] == 1;
+    }
+    if (needed) {
+      kept.push_back(i);
+      continue;
+    }
+    for (int f = 0; f < COVER_FEATURE_COUNT; f++) {
+      times_covered[f] -= coverage[i].features[f];
+    }
+  }
+  std::sort(kept.begin(), kept.end());
+  return kept;
+}
@@ -0,0 +1,65 @@
+/* ----------------------------------------------------------
+**
+**
+**   Coverage features of test cases, and suite minimisation
+**
+**   Each case is rendered with the model and marked with the
+**   behaviours it exercises: colour-map branches, the spread
+**   index clamp, zoom and iteration trapping, ack modes, the
+**   iteration histogram and position wrap-around. A greedy
+**   weighted set cover then picks the cheapest subset, in RTL
+**   cycles, that still covers every feature the candidates do.
+**
+**   Luke Rule
+**
+---------------------------------------------------------- */
+#ifndef SUITE_COVERAGE_H
+#define SUITE_COVERAGE_H
+
+#include <stdint.h>
+#include <bitset>
+#include <string>
+#include <vector>
+
+#include "batch_render.h"
+#include "frame_stats.h"
+
+enum coverage_feature {
+  COVER_COLOUR_MAP_SAMPLE,        // generate_colour_map skips unique colours
+  COVER_COLOUR_MAP_REPEAT,        // generate_colour_map repeats unique colours
+  COVER_COLOUR_FLAT_SEGMENT,      // two neighbouring interpolation points are equal
+  COVER_SPREAD_IDENTITY,          // get_spread_colour_index with max_iterations < 16
+  COVER_SPREAD_IN_RANGE,          // a spread index below max_iterations
+  COVER_SPREAD_CLAMP,             // a spread index clamped to max_iterations - 1
+  COVER_ZOOM_TRAP_HIGH,           // zoom > MAX_ZOOM drawn as 0
+  COVER_ZOOM_TRAP_LOW,            // negative zoom drawn as 0
+  COVER_ITERATIONS_TRAP_LOW,      // max_iterations <= 0 drawn as 1
+  COVER_ITERATIONS_TRAP_HIGH,     // max_iterations > MAX_ITERATIONS drawn as 1
+  COVER_ITERATIONS_LIMIT,         // max_iterations == MAX_ITERATIONS
+  COVER_ACK_INSTANT,
+  COVER_ACK_DELAYED,
+  COVER_POSITION_WRAP,            // the frame runs off the Q3.29 range and wraps
+  COVER_ZOOM_LEVEL,               // + zoom, 0 to MAX_ZOOM after trapping
+  COVER_HISTOGRAM_BIN = COVER_ZOOM_LEVEL + MAX_ZOOM + 1,   // + bin, as in frame_stats
+  COVER_FEATURE_COUNT = COVER_HISTOGRAM_BIN + STATS_HISTOGRAM_BINS
+};
+
+using coverage_set = std::bitset<COVER_FEATURE_COUNT>;
+
+struct case_coverage {
+  coverage_set features;
+  uint64_t hardware_cycles = 0;   // RTL cycles to draw the case, the cost of keeping it
+};
+
+// e.g. "spread_clamp", "zoom_3", "histogram_17"
+std::string coverage_feature_name(int feature);
+
+// render every case (each distinct view once) and record its features
+std::vector<case_coverage> measure_coverage(const std::vector<test_case>& cases, int width = DEFAULT_XSIZE, int height = DEFAULT_YSIZE,
+                                            int threads = 1);
+
+// Indices of a subset covering every feature some case covers, in input order. Greedy: most new
+// features per cycle first, then cases whose features the others all cover are dropped again.
+std::vector<int> minimise_suite(const std::vector<case_coverage>& coverage);
+
+#endif
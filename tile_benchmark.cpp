@@ -0,0 +1,237 @@
+/* ----------------------------------------------------------
+**
+**
+**   Tiled layout benchmark
+**
+**   Compares the row-major and Morton-tiled iteration buffers
+**   for multithreaded rendering, a neighbour-based post-process
+**   and the de-tiling pass itself
+**
+**   usage: tile_benchmark [--threads N] [--reps R] [--size WxH]
+**
+**   Luke Rule
+**
+---------------------------------------------------------- */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <algorithm>
+
+#include "mandelbrot_renderer.h"
+#include "tile_layout.h"
+
+struct bench_view {
+  const char* name;
+  double x;
+  double y;
+  int zoom;
+  int max_iterations;
+};
+
+static fixed_32 to_fixed(double value) {
+  return fixed_32(int64_t(value * (1 << FRAC_BITS)));
+}
+
+// best of reps runs, in seconds
+static double time_best(int reps, const std::function<void()>& work) {
+  double best = 1e30;
+  for (int r = 0; r < reps; r++) {
+    auto start = std::chrono::steady_clock::now();
+    work();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    best = std::min(best, elapsed.count());
+  }
+  return best;
+}
+
+static void run_threads(int threads, const std::function<void(int)>& work) {
+  std::vector<std::thread> workers;
+  for (int t = 0; t < threads; t++) {
+    workers.emplace_back(work, t);
+  }
+  for (std::thread& w : workers) {
+    w.join();
+  }
+}
+
+// parallel tile writers into a plain row-major buffer: tile edges share cache lines between threads
+static void iterate_row_major_tiles(const coord_step& c, int max_iterations, uint16_t* buffer, int width, int height, size_t stride, int threads) {
+  int tiles_x = (width + TILE_SIZE - 1) / TILE_SIZE;
+  int tiles = tiles_x * ((height + TILE_SIZE - 1) / TILE_SIZE);
+  std::atomic<int> next_tile(0);
+  run_threads(threads, [&](int) {
+    int tile;
+    while ((tile = next_tile.fetch_add(1)) < tiles) {
+      int x0 = (tile % tiles_x) * TILE_SIZE;
+      int y0 = (tile / tiles_x) * TILE_SIZE;
+      for (int y = y0; y < std::min(y0 + TILE_SIZE, height); y++) {
+        fixed_32 y_pos = step_coord(c.y, c.step, -y);
+        for (int x = x0; x < std::min(x0 + TILE_SIZE, width); x++) {
+          buffer[y * stride + x] = iterate_point(step_coord(c.x, c.step, x), y_pos, max_iterations);
+        }
+      }
+    }
+  });
+}
+
+// Neighbour post-process: count pixels whose iteration count differs from a 4-neighbour,
+// the core of edge detection and boundary tracing. Rows are split into bands per thread.
+static long boundary_row_major(const uint16_t* buffer, int width, int height, size_t stride, int threads) {
+  std::atomic<long> total(0);
+  run_threads(threads, [&](int t) {
+    long count = 0;
+    for (int y = 1 + t; y < height - 1; y += threads) {
+      const uint16_t* row = buffer + y * stride;
+      for (int x = 1; x < width - 1; x++) {
+        uint16_t v = row[x];
+        count += (row[x - 1] != v) | (row[x + 1] != v) | (row[x - stride] != v) | (row[x + stride] != v);
+      }
+    }
+    total += count;
+  });
+  return total;
+}
+
+// same pass over the tiled buffer: tile interiors use fixed in-tile offsets, only the tile
+// border goes through the layout lookup
+static long boundary_tiled(const uint16_t* buffer, const tile_layout& layout, int threads) {
+  int slots = layout.tiles_x * layout.tiles_y;
+  std::atomic<int> next_slot(0);
+  std::atomic<long> total(0);
+  run_threads(threads, [&](int) {
+    long count = 0;
+    int slot;
+    while ((slot = next_slot.fetch_add(1)) < slots) {
+      const uint16_t* tile = buffer + size_t(slot) * TILE_PIXELS;
+      int x0 = (layout.tile_of_slot[slot] & 0xffff) * TILE_SIZE;
+      int y0 = (layout.tile_of_slot[slot] >> 16) * TILE_SIZE;
+      bool inside = x0 > 0 && y0 > 0 && x0 + TILE_SIZE < layout.width && y0 + TILE_SIZE < layout.height;
+      for (int ty = 0; ty < TILE_SIZE; ty++) {
+        int y = y0 + ty;
+        bool border_row = ty == 0 || ty == TILE_SIZE - 1;
+        if (inside && !border_row) {
+          // interior of the tile: fixed offsets, no lookups
+          const uint16_t* p = tile + ty * TILE_SIZE;
+          for (int tx = 1; tx < TILE_SIZE - 1; tx++) {
+            uint16_t v = p[tx];
+            count += (p[tx - 1] != v) | (p[tx + 1] != v) | (p[tx - TILE_SIZE] != v) | (p[tx + TILE_SIZE] != v);
+          }
+        }
+        if (y < 1 || y >= layout.height - 1) {
+          continue;
+        }
+        for (int tx = 0; tx < TILE_SIZE; tx++) {
+          int x = x0 + tx;
+          bool border = border_row || tx == 0 || tx == TILE_SIZE - 1;
+          if ((inside && !border) || x < 1 || x >= layout.width - 1) {
+            continue;
+          }
+          uint16_t v = tile[ty * TILE_SIZE + tx];
+          count += (buffer[tiled_offset(layout, x - 1, y)] != v) | (buffer[tiled_offset(layout, x + 1, y)] != v) |
+                   (buffer[tiled_offset(layout, x, y - 1)] != v) | (buffer[tiled_offset(layout, x, y + 1)] != v);
+        }
+      }
+    }
+    total += count;
+  });
+  return total;
+}
+
+int main(int argc, char** argv)
+{
+  int threads = std::max(1u, std::thread::hardware_concurrency());
+  int reps = 5;
+  int width = DEFAULT_XSIZE;
+  int height = DEFAULT_YSIZE;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+      threads = std::max(1, atoi(argv[++i]));
+    }
+    else if (strcmp(argv[i], "--reps") == 0 && i + 1 < argc) {
+      reps = std::max(1, atoi(argv[++i]));
+    }
+    else if (strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+      if (sscanf(argv[++i], "%dx%d", &width, &height) != 2 || width < 3 || height < 3 || width > MAX_XSIZE || height > MAX_YSIZE) {
+        fprintf(stderr, "bad size\n");
+        return 1;
+      }
+    }
+  }
+
+  const bench_view views[] = {
+    {"full view", -0.5, 0.0, 0, 180},
+    {"seahorse valley", -0.745, 0.186, 6, 180},
+    {"elephant valley", 0.273, 0.007, 7, 180},
+  };
+
+  tile_layout layout;
+  build_tile_layout(layout, width, height);
+  const size_t row_align = BUFFER_ALIGNMENT / sizeof(uint16_t);
+  size_t stride = (size_t(width) + row_align - 1) & ~(row_align - 1);
+  aligned_buffer<uint16_t> row_major;
+  aligned_buffer<uint16_t> tiled;
+  aligned_buffer<uint16_t> detiled;
+  row_major.reserve(stride * height);
+  tiled.reserve(tiled_size(layout));
+  detiled.reserve(stride * height);
+  std::fill(tiled.data(), tiled.data() + tiled_size(layout), 0);
+  double mpixels = double(width) * height / 1e6;
+
+  printf("%dx%d, %d threads, best of %d\n\n", width, height, threads, reps);
+  printf("%-16s %12s %12s %12s\n", "render Mpix/s", "rows", "row tiles", "Z tiles");
+  for (const bench_view& v : views) {
+    coord_step c = center_coords(to_fixed(v.x), to_fixed(v.y), v.zoom, width, height);
+    double t_rows = time_best(reps, [&] {
+      iterateMandelbrotParallel(c.x, c.y, c.step, v.max_iterations, row_major.data(), width, height, stride, threads);
+    });
+    double t_row_tiles = time_best(reps, [&] {
+      iterate_row_major_tiles(c, v.max_iterations, row_major.data(), width, height, stride, threads);
+    });
+    double t_tiled = time_best(reps, [&] {
+      iterateMandelbrotTilesParallel(c.x, c.y, c.step, v.max_iterations, tiled.data(), layout, threads);
+    });
+    printf("%-16s %12.2f %12.2f %12.2f\n", v.name, mpixels / t_rows, mpixels / t_row_tiles, mpixels / t_tiled);
+
+    // the two layouts must hold the same frame
+    detile(layout, tiled.data(), detiled.data(), stride);
+    for (int y = 0; y < height; y++) {
+      if (memcmp(row_major.data() + y * stride, detiled.data() + y * stride, width * sizeof(uint16_t)) != 0) {
+        fprintf(stderr, "tiled render differs from row-major on row %d\n", y);
+        return 1;
+      }
+    }
+  }
+
+  printf("\n%-16s %12s %12s %12s %12s\n", "post Mpix/s", "rows", "Z tiles", "detile GB/s", "scalar GB/s");
+  for (const bench_view& v : views) {
+    coord_step c = center_coords(to_fixed(v.x), to_fixed(v.y), v.zoom, width, height);
+    iterateMandelbrotParallel(c.x, c.y, c.step, v.max_iterations, row_major.data(), width, height, stride, threads);
+    iterateMandelbrotTilesParallel(c.x, c.y, c.step, v.max_iterations, tiled.data(), layout, threads);
+
+    long edges_rows = 0;
+    long edges_tiled = 0;
+    double t_rows = time_best(reps, [&] { edges_rows = boundary_row_major(row_major.data(), width, height, stride, threads); });
+    double t_tiled = time_best(reps, [&] { edges_tiled = boundary_tiled(tiled.data(), layout, threads); });
+    if (edges_rows != edges_tiled) {
+      fprintf(stderr, "post-process results differ: %ld vs %ld\n", edges_rows, edges_tiled);
+      return 1;
+    }
+
+    double t_detile = time_best(reps, [&] { detile(layout, tiled.data(), detiled.data(), stride); });
+    // per-pixel gather through the layout lookup, the obvious non-SIMD way to de-tile
+    double t_scalar = time_best(reps, [&] {
+      for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+          detiled.data()[y * stride + x] = tiled.data()[tiled_offset(layout, x, y)];
+        }
+      }
+    });
+    double gbytes = double(width) * height * sizeof(uint16_t) / 1e9;
+    printf("%-16s %12.2f %12.2f %12.2f %12.2f\n", v.name, mpixels / t_rows, mpixels / t_tiled, gbytes / t_detile, gbytes / t_scalar);
+  }
+}
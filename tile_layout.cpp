@@ -0,0 +1,136 @@
+/* ----------------------------------------------------------
+**
+**
+**   Cache-blocked tile layout for iteration and colour buffers
+**
+**   Luke Rule
+**
+---------------------------------------------------------- */
+#include "tile_layout.h"
+
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// spread the low 16 bits of v out to the even bit positions
+static uint32_t spread_bits(uint32_t v) {
+  v &= 0xffff;
+  v = (v | (v << 8)) & 0x00ff00ff;
+  v = (v | (v << 4)) & 0x0f0f0f0f;
+  v = (v | (v << 2)) & 0x33333333;
+  v = (v | (v << 1)) & 0x55555555;
+  return v;
+}
+
+void build_tile_layout(tile_layout& layout, int width, int height) {
+  layout.width = width;
+  layout.height = height;
+  layout.tiles_x = (width + TILE_SIZE - 1) / TILE_SIZE;
+  layout.tiles_y = (height + TILE_SIZE - 1) / TILE_SIZE;
+
+  int tiles = layout.tiles_x * layout.tiles_y;
+  std::vector<std::pair<uint32_t, uint32_t>> order;
+  for (int ty = 0; ty < layout.tiles_y; ty++) {
+    for (int tx = 0; tx < layout.tiles_x; tx++) {
+      order.push_back({spread_bits(tx) | (spread_bits(ty) << 1), uint32_t(ty << 16 | tx)});
+    }
+  }
+  std::sort(order.begin(), order.end());
+
+  layout.slot_of_tile.assign(tiles, 0);
+  layout.tile_of_slot.assign(tiles, 0);
+  for (int slot = 0; slot < tiles; slot++) {
+    uint32_t tile = order[slot].second;
+    layout.tile_of_slot[slot] = tile;
+    layout.slot_of_tile[(tile >> 16) * layout.tiles_x + (tile & 0xffff)] = slot;
+  }
+}
+
+// iterate the pixels of one tile that fall inside the frame
+static void iterate_tile(fixed_32 x_fixed, fixed_32 y_fixed, fixed_32 inc_fixed, int max_iterations, uint16_t* tile, const tile_layout& layout, int slot) {
+  int tx = layout.tile_of_slot[slot] & 0xffff;
+  int ty = layout.tile_of_slot[slot] >> 16;
+  int x0 = tx * TILE_SIZE;
+  int y0 = ty * TILE_SIZE;
+  int x1 = std::min(x0 + TILE_SIZE, layout.width);
+  int y1 = std::min(y0 + TILE_SIZE, layout.height);
+  for (int y = y0; y < y1; y++) {
+    uint16_t* row = tile + (y - y0) * TILE_SIZE;
+    fixed_32 y_pos = step_coord(y_fixed, inc_fixed, -y);
+    fixed_32 x_pos = step_coord(x_fixed, inc_fixed, x0);
+    for (int x = x0; x < x1; x++) {
+      row[x - x0] = iterate_point(x_pos, y_pos, max_iterations);
+      x_pos = step_coord(x_pos, inc_fixed, 1);
+    }
+  }
+}
+
+void iterateMandelbrotTiles(fixed_32 x_fixed, fixed_32 y_fixed, fixed_32 inc_fixed, int max_iterations, uint16_t* tiled_buffer, const tile_layout& layout, int first_slot, int slot_step) {
+  int slots = layout.tiles_x * layout.tiles_y;
+  for (int slot = first_slot; slot < slots; slot += slot_step) {
+    iterate_tile(x_fixed, y_fixed, inc_fixed, max_iterations, tiled_buffer + size_t(slot) * TILE_PIXELS, layout, slot);
+  }
+}
+
+void iterateMandelbrotTilesParallel(fixed_32 x_fixed, fixed_32 y_fixed, fixed_32 inc_fixed, int max_iterations, uint16_t* tiled_buffer, const tile_layout& layout, int threads) {
+  if (threads <= 1) {
+    iterateMandelbrotTiles(x_fixed, y_fixed, inc_fixed, max_iterations, tiled_buffer, layout, 0, 1);
+    return;
+  }
+  int slots = layout.tiles_x * layout.tiles_y;
+  std::atomic<int> next_slot(0);
+  auto worker = [&]() {
+    int slot;
+    while ((slot = next_slot.fetch_add(1, std::memory_order_relaxed)) < slots) {
+      iterate_tile(x_fixed, y_fixed, inc_fixed, max_iterations, tiled_buffer + size_t(slot) * TILE_PIXELS, layout, slot);
+    }
+  };
+  std::vector<std::thread> workers;
+  for (int t = 0; t < threads; t++) {
+    workers.emplace_back(worker);
+  }
+  for (std::thread& w : workers) {
+    w.join();
+  }
+}
+
+// one full tile row is 16 pixels, two 128-bit moves
+static inline void copy_tile_row(uint16_t* out, const uint16_t* in) {
+#if defined(__SSE2__)
+  __m128i lo = _mm_load_si128(reinterpret_cast<const __m128i*>(in));
+  __m128i hi = _mm_load_si128(reinterpret_cast<const __m128i*>(in + 8));
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(out), lo);
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 8), hi);
+#else
+  memcpy(out, in, TILE_SIZE * sizeof(uint16_t));
+#endif
+}
+
+void detile(const tile_layout& layout, const uint16_t* tiled_buffer, uint16_t* out, size_t stride) {
+  int slots = layout.tiles_x * layout.tiles_y;
+  // walk storage in order so the tiled buffer streams in sequentially
+  for (int slot = 0; slot < slots; slot++) {
+    const uint16_t* tile = tiled_buffer + size_t(slot) * TILE_PIXELS;
+    int x0 = (layout.tile_of_slot[slot] & 0xffff) * TILE_SIZE;
+    int y0 = (layout.tile_of_slot[slot] >> 16) * TILE_SIZE;
+    int rows = std::min(TILE_SIZE, layout.height - y0);
+    int columns = std::min(TILE_SIZE, layout.width - x0);
+    uint16_t* dest = out + size_t(y0) * stride + x0;
+    if (columns == TILE_SIZE) {
+      for (int r = 0; r < rows; r++) {
+        copy_tile_row(dest + r * stride, tile + r * TILE_SIZE);
+      }
+    }
+    else {
+      // right-hand edge tile hanging off the frame
+      for (int r = 0; r < rows; r++) {
+        memcpy(dest + r * stride, tile + r * TILE_SIZE, columns * sizeof(uint16_t));
+      }
+    }
+  }
+}
@@ -0,0 +1,59 @@
+/* ----------------------------------------------------------
+**
+**
+**   Cache-blocked tile layout for iteration and colour buffers
+**
+**   Frames are stored as TILE_SIZE x TILE_SIZE tiles, tiles in
+**   Morton (Z) order and pixels row-major inside each tile
+**
+**   Luke Rule
+**
+---------------------------------------------------------- */
+#ifndef TILE_LAYOUT_H
+#define TILE_LAYOUT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+#include "mandelbrot_fixed.h"
+
+// 16x16 16-bit pixels is 512 bytes, so a tile is 8 whole cache lines and tiles never share a line
+#define TILE_SIZE 16
+#define TILE_PIXELS (TILE_SIZE * TILE_SIZE)
+
+struct tile_layout {
+  int width = 0;
+  int height = 0;
+  int tiles_x = 0;
+  int tiles_y = 0;
+  // storage slot of each tile, indexed by ty * tiles_x + tx
+  std::vector<uint32_t> slot_of_tile;
+  // tile coordinates (ty << 16 | tx) of each storage slot, i.e. the Morton walk
+  std::vector<uint32_t> tile_of_slot;
+};
+
+// Tiles are ranked by the Morton code of their tile coordinates. Frame sizes are rarely powers
+// of two, so rather than leave holes in storage the codes are sorted and each tile takes its rank.
+void build_tile_layout(tile_layout& layout, int width, int height);
+
+// elements needed to hold a frame in this layout, edge tiles included
+inline size_t tiled_size(const tile_layout& layout) {
+  return size_t(layout.tiles_x) * layout.tiles_y * TILE_PIXELS;
+}
+
+inline size_t tiled_offset(const tile_layout& layout, int x, int y) {
+  uint32_t slot = layout.slot_of_tile[(y / TILE_SIZE) * layout.tiles_x + (x / TILE_SIZE)];
+  return size_t(slot) * TILE_PIXELS + (y % TILE_SIZE) * TILE_SIZE + (x % TILE_SIZE);
+}
+
+// iteration counts for storage slots first_slot, first_slot + slot_step, ...
+void iterateMandelbrotTiles(fixed_32 x_fixed, fixed_32 y_fixed, fixed_32 inc_fixed, int max_iterations, uint16_t* tiled_buffer, const tile_layout& layout, int first_slot, int slot_step);
+// Threads claim tiles one at a time in Morton order, so neighbouring threads work on nearby
+// tiles and no two threads ever write to the same cache line.
+void iterateMandelbrotTilesParallel(fixed_32 x_fixed, fixed_32 y_fixed, fixed_32 inc_fixed, int max_iterations, uint16_t* tiled_buffer, const tile_layout& layout, int threads);
+
+// copy a tiled buffer out to row-major, a whole tile row (32 bytes) per vector move
+void detile(const tile_layout& layout, const uint16_t* tiled_buffer, uint16_t* out, size_t stride);
+
+#endif
@@ -0,0 +1,152 @@
+/* ----------------------------------------------------------
+**
+**
+**   Cost-aware tile scheduling
+**
+**   Luke Rule
+**
+---------------------------------------------------------- */
+#include "tile_scheduler.h"
+
+#include <time.h>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <functional>
+#include <algorithm>
+
+// CPU time of the calling thread, which unlike wall time does not grow while it waits for a core
+static double thread_cpu_seconds() {
+  timespec ts;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void run_threads(int threads, const std::function<void(int)>& work) {
+  if (threads <= 1) {
+    work(0);
+    return;
+  }
+  std::vector<std::thread> workers;
+  for (int t = 0; t < threads; t++) {
+    workers.emplace_back(work, t);
+  }
+  for (std::thread& w : workers) {
+    w.join();
+  }
+}
+
+// iterate one tile of a row-major buffer, leaving out the estimate grid when skip_estimates is set
+static void iterate_tile_pixels(fixed_32 x_fixed, fixed_32 y_fixed, fixed_32 inc_fixed, int max_iterations, uint16_t* buffer, int width, int height, size_t stride, int tile_x, int tile_y, bool skip_estimates) {
+  int x0 = tile_x * TILE_SIZE;
+  int y0 = tile_y * TILE_SIZE;
+  int x1 = std::min(x0 + TILE_SIZE, width);
+  int y1 = std::min(y0 + TILE_SIZE, height);
+  for (int y = y0; y < y1; y++) {
+    uint16_t* row = buffer + y * stride;
+    fixed_32 y_pos = step_coord(y_fixed, inc_fixed, -y);
+    bool estimate_row = skip_estimates && y % ESTIMATE_STRIDE == 0;
+    for (int x = x0; x < x1; x++) {
+      if (estimate_row && x % ESTIMATE_STRIDE == 0) {
+        continue;
+      }
+      row[x] = iterate_point(step_coord(x_fixed, inc_fixed, x), y_pos, max_iterations);
+    }
+  }
+}
+
+// threads claim tiles from order one at a time
+static void dispatch_tiles(fixed_32 x_fixed, fixed_32 y_fixed, fixed_32 inc_fixed, int max_iterations, uint16_t* buffer, int width, int height, size_t stride, int threads, const std::vector<int>& order, bool skip_estimates, tile_schedule_stats* stats) {
+  int tiles_x = (width + TILE_SIZE - 1) / TILE_SIZE;
+  std::atomic<size_t> next(0);
+  if (stats != nullptr) {
+    stats->thread_seconds.assign(std::max(1, threads), 0.0);
+    stats->tile_seconds.assign(order.size(), 0.0f);
+    stats->order = order;
+  }
+  run_threads(threads, [&](int t) {
+    auto thread_start = std::chrono::steady_clock::now();
+    size_t i;
+    while ((i = next.fetch_add(1, std::memory_order_relaxed)) < order.size()) {
+      int tile = order[i];
+      double tile_start = stats != nullptr ? thread_cpu_seconds() : 0.0;
+      iterate_tile_pixels(x_fixed, y_fixed, inc_fixed, max_iterations, buffer, width, height, stride, tile % tiles_x, tile / tiles_x, skip_estimates);
+      if (stats != nullptr) {
+        stats->tile_seconds[tile] = float(thread_cpu_seconds() - tile_start);
+      }
+    }
+    if (stats != nullptr) {
+      stats->thread_seconds[t] = std::chrono::duration<double>(std::chrono::steady_clock::now() - thread_start).count();
+    }
+  });
+}
+
+void iterateMandelbrotLPT(fixed_32 x_fixed, fixed_32 y_fixed, fixed_32 inc_fixed, int max_iterations, uint16_t* iteration_buffer, int width, int height, size_t stride, int threads, tile_schedule_stats* stats) {
+  auto start = std::chrono::steady_clock::now();
+  int tiles_x = (width + TILE_SIZE - 1) / TILE_SIZE;
+  int tiles_y = (height + TILE_SIZE - 1) / TILE_SIZE;
+
+  // estimate pass, straight into the frame; estimate rows interleaved across threads
+  int estimate_rows = (height + ESTIMATE_STRIDE - 1) / ESTIMATE_STRIDE;
+  std::vector<double> estimate_work(std::max(1, threads), 0.0);
+  run_threads(threads, [&](int t) {
+    double thread_start = thread_cpu_seconds();
+    for (int r = t; r < estimate_rows; r += std::max(1, threads)) {
+      int y = r * ESTIMATE_STRIDE;
+      uint16_t* row = iteration_buffer + y * stride;
+      fixed_32 y_pos = step_coord(y_fixed, inc_fixed, -y);
+      for (int x = 0; x < width; x += ESTIMATE_STRIDE) {
+        row[x] = iterate_point(step_coord(x_fixed, inc_fixed, x), y_pos, max_iterations);
+      }
+    }
+    estimate_work[t] = thread_cpu_seconds() - thread_start;
+  });
+
+  std::vector<uint64_t> cost(size_t(tiles_x) * tiles_y, 0);
+  for (int y = 0; y < height; y += ESTIMATE_STRIDE) {
+    const uint16_t* row = iteration_buffer + y * stride;
+    for (int x = 0; x < width; x += ESTIMATE_STRIDE) {
+      cost[(y / TILE_SIZE) * tiles_x + x / TILE_SIZE] += row[x] + ESTIMATE_PIXEL_COST;
+    }
+  }
+  std::vector<int> order(cost.size());
+  for (size_t i = 0; i < order.size(); i++) {
+    order[i] = i;
+  }
+  // ties keep scanline order, so equal-cost runs stay cache friendly
+  std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return cost[a] > cost[b]; });
+  auto estimated = std::chrono::steady_clock::now();
+
+  dispatch_tiles(x_fixed, y_fixed, inc_fixed, max_iterations, iteration_buffer, width, height, stride, threads, order, true, stats);
+  if (stats != nullptr) {
+    stats->estimate_seconds = std::chrono::duration<double>(estimated - start).count();
+    stats->estimate_work_seconds = 0.0;
+    for (double seconds : estimate_work) {
+      stats->estimate_work_seconds += seconds;
+    }
+    stats->render_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  }
+}
+
+void iterateMandelbrotScanlineTiles(fixed_32 x_fixed, fixed_32 y_fixed, fixed_32 inc_fixed, int max_iterations, uint16_t* iteration_buffer, int width, int height, size_t stride, int threads, tile_schedule_stats* stats) {
+  auto start = std::chrono::steady_clock::now();
+  int tiles = ((width + TILE_SIZE - 1) / TILE_SIZE) * ((height + TILE_SIZE - 1) / TILE_SIZE);
+  std::vector<int> order(tiles);
+  for (int i = 0; i < tiles; i++) {
+    order[i] = i;
+  }
+  dispatch_tiles(x_fixed, y_fixed, inc_fixed, max_iterations, iteration_buffer, width, height, stride, threads, order, false, stats);
+  if (stats != nullptr) {
+    stats->estimate_seconds = 0.0;
+    stats->estimate_work_seconds = 0.0;
+    stats->render_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  }
+}
+
+double simulated_makespan(const std::vector<int>& order, const std::vector<float>& tile_seconds, int threads) {
+  std::vector<double> free_at(std::max(1, threads), 0.0);
+  for (int tile : order) {
+    *std::min_element(free_at.begin(), free_at.end()) += tile_seconds[tile];
+  }
+  return *std::max_element(free_at.begin(), free_at.end());
+}
@@ -0,0 +1,49 @@
+/* ----------------------------------------------------------
+**
+**
+**   Cost-aware tile scheduling
+**
+**   A cheap pass iterates every ESTIMATE_STRIDE'th pixel in x
+**   and y, giving each TILE_SIZE tile a cost estimate. Tiles are
+**   then handed to threads longest-processing-time first, so the
+**   expensive interior tiles start early instead of finishing
+**   last. Estimate samples are real pixels of the frame and are
+**   not iterated again.
+**
+**   Luke Rule
+**
+---------------------------------------------------------- */
+#ifndef TILE_SCHEDULER_H
+#define TILE_SCHEDULER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+#include "mandelbrot_fixed.h"
+#include "tile_layout.h"
+
+// 1 in 16 pixels for the estimate pass
+#define ESTIMATE_STRIDE 4
+// per-pixel overhead in units of one iteration, so all-exterior tiles are not costed at zero
+#define ESTIMATE_PIXEL_COST 1
+
+struct tile_schedule_stats {
+  double estimate_seconds = 0.0;
+  double estimate_work_seconds = 0.0;    // CPU time of the estimate pass summed over its threads
+  double render_seconds = 0.0;           // whole call, estimate included
+  std::vector<double> thread_seconds;    // busy time of each thread in the tile phase
+  std::vector<int> order;                // tile indices (ty * tiles_x + tx) in dispatch order
+  std::vector<float> tile_seconds;       // CPU time of each tile, by tile index
+};
+
+// Row-major iteration buffer, tiles dispatched longest first. stats is optional.
+void iterateMandelbrotLPT(fixed_32 x_fixed, fixed_32 y_fixed, fixed_32 inc_fixed, int max_iterations, uint16_t* iteration_buffer, int width, int height, size_t stride, int threads, tile_schedule_stats* stats = nullptr);
+// The naive split for comparison: the same tiles claimed in scanline order, no estimate pass.
+void iterateMandelbrotScanlineTiles(fixed_32 x_fixed, fixed_32 y_fixed, fixed_32 inc_fixed, int max_iterations, uint16_t* iteration_buffer, int width, int height, size_t stride, int threads, tile_schedule_stats* stats = nullptr);
+
+// Finishing time of list-scheduling tiles in order onto threads, from per-tile costs. Lets the
+// two orders be compared for any thread count on a machine with fewer cores.
+double simulated_makespan(const std::vector<int>& order, const std::vector<float>& tile_seconds, int threads);
+
+#endif
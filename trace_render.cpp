@@ -0,0 +1,119 @@
+/* ----------------------------------------------------------
+**
+**
+**   Boundary-tracing render timing and audit
+**
+**   Traces every distinct view of an input file and reports
+**   the share of pixels iterated and the time taken. With
+**   --audit each view is also rendered brute force, and the
+**   pixels the trace got wrong are counted.
+**
+**   usage: trace_render [--input file] [--size WxH]
+**                       [--case N] [--iterations N]
+**                       [--threads N] [--audit]
+**
+**   --iterations overrides every case's max iterations, e.g.
+**   1023 to see the high-iteration views tracing is for.
+**   Exits with status 1 if the audit finds a wrong pixel.
+**
+**   Luke Rule
+**
+---------------------------------------------------------- */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+
+#include "mandelbrot_renderer.h"
+#include "batch_render.h"
+#include "boundary_trace.h"
+
+int main(int argc, char** argv)
+{
+  std::string input_file = "/home/p74644lr/Questa/COMP32211/src/Phase_2/input_file.txt";
+  int width = DEFAULT_XSIZE;
+  int height = DEFAULT_YSIZE;
+  int only_case = -1;
+  int iterations_override = 0;
+  int threads = 1;
+  bool audit = false;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--input") == 0 && i + 1 < argc) {
+      input_file = argv[++i];
+    }
+    else if (strcmp(argv[i], "--case") == 0 && i + 1 < argc) {
+      only_case = atoi(argv[++i]);
+    }
+    else if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+      iterations_override = std::min(MAX_ITERATIONS, std::max(1, atoi(argv[++i])));
+    }
+    else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+      threads = std::max(1, atoi(argv[++i]));
+    }
+    else if (strcmp(argv[i], "--audit") == 0) {
+      audit = true;
+    }
+    else if (strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+      if (sscanf(argv[++i], "%dx%d", &width, &height) != 2 || width < 1 || height < 1 || width > MAX_XSIZE || height > MAX_YSIZE) {
+        fprintf(stderr, "bad size\n");
+        return 1;
+      }
+    }
+  }
+
+  std::vector<test_case> cases = read_test_cases(input_file);
+  if (cases.empty()) {
+    fprintf(stderr, "no cases in %s\n", input_file.c_str());
+    return 1;
+  }
+  if (iterations_override > 0) {
+    for (test_case& t : cases) {
+      t.max_iterations = iterations_override;
+    }
+  }
+  std::vector<geometry_group> groups = plan_geometry_groups(cases, true, width, height);
+  std::vector<uint16_t> traced(size_t(width) * height);
+  std::vector<uint16_t> brute(size_t(width) * height);
+  double traced_total = 0.0;
+  double brute_total = 0.0;
+  uint64_t wrong_total = 0;
+
+  printf("%-6s %6s %9s %9s", "case", "iters", "iterated", "traced");
+  if (audit) {
+    printf(" %9s %7s %7s", "brute", "speedup", "wrong");
+  }
+  printf("\n");
+  for (const geometry_group& g : groups) {
+    int file_count = cases[g.cases[0]].file_count;
+    if (only_case >= 0 && std::find_if(g.cases.begin(), g.cases.end(), [&](int i) { return cases[i].file_count == only_case; }) == g.cases.end()) {
+      continue;
+    }
+    trace_stats stats;
+    auto start = std::chrono::steady_clock::now();
+    iterateMandelbrotTraced(g.c.x, g.c.y, g.c.step, g.max_iterations, traced.data(), width, height, width, threads, &stats);
+    double traced_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    traced_total += traced_ms;
+    printf("%-6d %6d %8.1f%% %7.1fms", file_count, g.max_iterations, 100.0 * stats.iterated / (double(width) * height), traced_ms);
+    if (audit) {
+      start = std::chrono::steady_clock::now();
+      iterateMandelbrotParallel(g.c.x, g.c.y, g.c.step, g.max_iterations, brute.data(), width, height, width, threads);
+      double brute_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+      brute_total += brute_ms;
+      uint64_t wrong = 0;
+      for (size_t i = 0; i < brute.size(); i++) {
+        wrong += brute[i] != traced[i];
+      }
+      wrong_total += wrong;
+      printf(" %7.1fms %6.2fx %7llu", brute_ms, brute_ms / traced_ms, (unsigned long long)wrong);
+    }
+    printf("\n");
+  }
+  if (audit && traced_total > 0.0) {
+    printf("total: %.1f ms traced, %.1f ms brute force (%.2fx), %llu wrong pixels\n", traced_total, brute_total, brute_total / traced_total,
+           (unsigned long long)wrong_total);
+  }
+  return wrong_total != 0 ? 1 : 0;
+}
@@ -0,0 +1,158 @@
+/* ----------------------------------------------------------
+**
+**
+**   Regression triage from pixel_errors.txt
+**
+**   Re-renders only the mismatching areas of each failing test
+**   and checks whether the model agrees with the expected
+**   (golden) colour or with what the RTL drew. Pixels the RTL
+**   never drew (got: x) are counted on their own.
+**
+**   usage: triage_errors [--errors pixel_errors.txt] [--input input_file.txt]
+**                        [--size WxH] [--test N] [--rect x,y,w,h]...
+**                        [--ppm dir] [--verbose]
+**
+**   With --rect the given rectangles of test N are rendered
+**   instead of the ones covering the logged mismatches.
+**
+**   Luke Rule
+**
+---------------------------------------------------------- */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <chrono>
+
+#include "mandelbrot_renderer.h"
+#include "batch_render.h"
+#include "region_render.h"
+
+int main(int argc, char** argv)
+{
+  std::string errors_file = "/home/p74644lr/Questa/COMP32211/src/Phase_2/pixel_errors.txt";
+  std::string input_file = "/home/p74644lr/Questa/COMP32211/src/Phase_2/input_file.txt";
+  std::string ppm_dir;
+  std::vector<pixel_rect> given_rects;
+  int width = DEFAULT_XSIZE;
+  int height = DEFAULT_YSIZE;
+  int only_test = -1;
+  bool verbose = false;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--errors") == 0 && i + 1 < argc) {
+      errors_file = argv[++i];
+    }
+    else if (strcmp(argv[i], "--input") == 0 && i + 1 < argc) {
+      input_file = argv[++i];
+    }
+    else if (strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+      if (sscanf(argv[++i], "%dx%d", &width, &height) != 2 ||
+          width < 1 || height < 1 || width > MAX_XSIZE || height > MAX_YSIZE) {
+        fprintf(stderr, "bad size %s, expected WxH up to %dx%d\n", argv[i], MAX_XSIZE, MAX_YSIZE);
+        return 1;
+      }
+    }
+    else if (strcmp(argv[i], "--test") == 0 && i + 1 < argc) {
+      only_test = atoi(argv[++i]);
+    }
+    else if (strcmp(argv[i], "--rect") == 0 && i + 1 < argc) {
+      pixel_rect r;
+      if (sscanf(argv[++i], "%d,%d,%d,%d", &r.x, &r.y, &r.width, &r.height) != 4) {
+        fprintf(stderr, "bad rect %s, expected x,y,width,height\n", argv[i]);
+        return 1;
+      }
+      given_rects.push_back(r);
+    }
+    else if (strcmp(argv[i], "--ppm") == 0 && i + 1 < argc) {
+      ppm_dir = argv[++i];
+    }
+    else if (strcmp(argv[i], "--verbose") == 0) {
+      verbose = true;
+    }
+  }
+
+  std::vector<test_case> cases = read_test_cases(input_file);
+  std::vector<test_errors> tests;
+  if (!given_rects.empty()) {
+    if (only_test < 0) {
+      fprintf(stderr, "--rect needs --test N\n");
+      return 1;
+    }
+    tests.push_back({only_test, {}});
+  }
+  else {
+    tests = read_pixel_errors(errors_file);
+    if (tests.empty()) {
+      fprintf(stderr, "no tests found in %s\n", errors_file.c_str());
+      return 1;
+    }
+  }
+
+  // grey like the batch renderer, so unrendered pixels stand out in the PPMs
+  std::vector<colour> framebuffer(size_t(width) * height);
+  int failing = 0;
+  for (const test_errors& t : tests) {
+    if ((only_test >= 0 && t.test != only_test) || (given_rects.empty() && t.errors.empty())) {
+      continue;
+    }
+    const test_case* found = find_test_case(cases, t.test);
+    if (found == nullptr) {
+      fprintf(stderr, "test %d is not in %s\n", t.test, input_file.c_str());
+      continue;
+    }
+    failing++;
+    const test_case& tc = *found;
+    coord_step c = center_coords(tc.center_x, tc.center_y, tc.zoom, width, height);
+    std::vector<colour> unique_colours;
+    std::vector<colour> interp_points(tc.colours, tc.colours + 6);
+    std::vector<colour> colour_map;
+    generate_unique_colours(unique_colours, interp_points);
+    generate_colour_map(tc.max_iterations, unique_colours, colour_map);
+
+    std::vector<pixel_rect> rects = given_rects.empty() ? cover_pixels(t.errors) : given_rects;
+    std::fill(framebuffer.begin(), framebuffer.end(), colour(0x7BEF));
+    auto start = std::chrono::steady_clock::now();
+    size_t pixels = drawMandelbrotRects(c, tc.max_iterations, rects, framebuffer.data(), width, height, width, colour_map);
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+    // which side of the mismatch the model is on
+    int model_expected = 0, model_got = 0, neither = 0, undrawn = 0;
+    for (const pixel_error& e : t.errors) {
+      if (e.x >= width || e.y >= height) {
+        neither++;
+        continue;
+      }
+      colour model = framebuffer[size_t(e.y) * width + e.x];
+      if (e.undrawn) {
+        undrawn++;
+      }
+      else if (model == e.expected) {
+        model_expected++;
+      }
+      else if (model == e.got) {
+        model_got++;
+      }
+      else {
+        neither++;
+      }
+      if (verbose) {
+        int iterations = iterate_point(step_coord(c.x, c.step, e.x), step_coord(c.y, c.step, -e.y), tc.max_iterations);
+        printf("  %d, %d: expected %d, got %s, model %d (%d of %d iterations)\n",
+               e.x, e.y, e.expected, e.undrawn ? "x" : std::to_string(e.got).c_str(), model, iterations, tc.max_iterations);
+      }
+    }
+    printf("Test %d: %zu mismatches, %zu rects, %zu pixels rendered in %.3f ms", t.test, t.errors.size(), rects.size(), pixels, elapsed.count());
+    if (!t.errors.empty()) {
+      printf(", model matches expected %d, got %d, neither %d; undrawn %d", model_expected, model_got, neither, undrawn);
+    }
+    printf("\n");
+    if (!ppm_dir.empty()) {
+      write_ppm_file(ppm_dir + "/" + std::to_string(t.test) + "_triage.ppm", framebuffer.data(), width, height, width);
+    }
+  }
+  if (failing == 0) {
+    printf("no failing tests\n");
+  }
+  return 0;
+}
@@ -0,0 +1,136 @@
+/* ----------------------------------------------------------
+**
+**
+**   Unrolled escape-check benchmark
+**
+**   Renders the benchmark views with the scalar row loop, then
+**   with iterateMandelbrotUnrolled at 4, 8 and 16 steps between
+**   escape checks, pixel by pixel and on SIMD lanes, and with
+**   iterateMandelbrotSIMD checking every step. Reports each
+**   time against the row loop; every count is checked against
+**   the row loop.
+**
+**   usage: unroll_benchmark [--size WxH] [--threads N]
+**                           [--iterations M] [--reps R]
+**
+**   Luke Rule
+**
+---------------------------------------------------------- */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <functional>
+
+#include "mandelbrot_renderer.h"
+#include "point_kernels.h"
+
+struct unroll_view {
+  const char* name;
+  double x;
+  double y;
+  int zoom;
+};
+
+static fixed_32 to_fixed(double value) {
+  return fixed_32(int64_t(value * (1 << FRAC_BITS)));
+}
+
+// best wall time of reps runs of work
+static double time_best(int reps, const std::function<void()>& work) {
+  double best = 1e30;
+  for (int r = 0; r < reps; r++) {
+    auto start = std::chrono::steady_clock::now();
+    work();
+    best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+  }
+  return best;
+}
+
+int main(int argc, char** argv)
+{
+  int width = DEFAULT_XSIZE;
+  int height = DEFAULT_YSIZE;
+  int threads = 1;
+  int max_iterations = 511;
+  int reps = 3;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+      threads = std::max(1, atoi(argv[++i]));
+    }
+    else if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+      max_iterations = std::min(MAX_ITERATIONS, std::max(1, atoi(argv[++i])));
+    }
+    else if (strcmp(argv[i], "--reps") == 0 && i + 1 < argc) {
+      reps = std::max(1, atoi(argv[++i]));
+    }
+    else if (strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+      if (sscanf(argv[++i], "%dx%d", &width, &height) != 2 || width < 1 || height < 1 || width > MAX_XSIZE || height > MAX_YSIZE) {
+        fprintf(stderr, "bad size\n");
+        return 1;
+      }
+    }
+  }
+
+  // the fixed windows of test_input_generator.py
+  const unroll_view views[] = {
+    {"full", -0.5, 0.0, 0},
+    {"cardioid_edge", -0.7467, 0.163, 6},
+    {"period2_valley", -0.749, 0.07, 5},
+    {"minibrot", -1.766, 0.0, 5},
+    {"outer_branches", -0.2, -0.865, 3},
+    {"very_zoomed", 0.001643721971153, -0.822467633298876, 8},
+    {"seahorse", -0.745, 0.186, 6},
+    {"elephant", 0.273, 0.007, 7},
+    {"origin", 0.0, 0.0, 0},
+  };
+  // the last four are on SIMD lanes; K = 1 is iterateMandelbrotSIMD, which checks every step
+  const char* names[] = {"K=4", "K=8", "K=16", "simd", "simd K=4", "simd K=8", "simd K=16"};
+  const std::function<void(const coord_step&, uint16_t*)> renderers[] = {
+    [&](const coord_step& c, uint16_t* out) { iterateMandelbrotUnrolled<4>(c.x, c.y, c.step, max_iterations, out, width, height, width, threads, false); },
+    [&](const coord_step& c, uint16_t* out) { iterateMandelbrotUnrolled<8>(c.x, c.y, c.step, max_iterations, out, width, height, width, threads, false); },
+    [&](const coord_step& c, uint16_t* out) { iterateMandelbrotUnrolled<16>(c.x, c.y, c.step, max_iterations, out, width, height, width, threads, false); },
+    [&](const coord_step& c, uint16_t* out) { iterateMandelbrotSIMD(c.x, c.y, c.step, max_iterations, out, width, height, width, threads); },
+    [&](const coord_step& c, uint16_t* out) { iterateMandelbrotUnrolled<4>(c.x, c.y, c.step, max_iterations, out, width, height, width, threads, true); },
+    [&](const coord_step& c, uint16_t* out) { iterateMandelbrotUnrolled<8>(c.x, c.y, c.step, max_iterations, out, width, height, width, threads, true); },
+    [&](const coord_step& c, uint16_t* out) { iterateMandelbrotUnrolled<16>(c.x, c.y, c.step, max_iterations, out, width, height, width, threads, true); },
+  };
+  const int kernels = sizeof(names) / sizeof(names[0]);
+
+  std::vector<uint16_t> reference(size_t(width) * height);
+  std::vector<uint16_t> buffer(size_t(width) * height);
+  printf("%dx%d, %d iterations, %d threads\n\n", width, height, max_iterations, threads);
+  printf("%-15s %9s", "view", "rows ms");
+  for (int k = 0; k < kernels; k++) {
+    printf(" %9s", names[k]);
+  }
+  printf("\n");
+  double rows_total = 0.0;
+  std::vector<double> totals(kernels);
+  for (const unroll_view& v : views) {
+    coord_step c = center_coords(to_fixed(v.x), to_fixed(v.y), v.zoom, width, height);
+    double rows = time_best(reps, [&] {
+      iterateMandelbrotParallel(c.x, c.y, c.step, max_iterations, reference.data(), width, height, width, threads);
+    });
+    rows_total += rows;
+    printf("%-15s %9.2f", v.name, rows * 1e3);
+    for (int k = 0; k < kernels; k++) {
+      double seconds = time_best(reps, [&] { renderers[k](c, buffer.data()); });
+      if (buffer != reference) {
+        fprintf(stderr, "\n%s: %s differs from the row render\n", v.name, names[k]);
+        return 1;
+      }
+      totals[k] += seconds;
+      printf(" %8.2fx", rows / seconds);
+    }
+    printf("\n");
+  }
+  printf("\nall views against rows (%.1f ms):", rows_total * 1e3);
+  for (int k = 0; k < kernels; k++) {
+    printf(" %s %.2fx%s", names[k], rows_total / totals[k], k + 1 < kernels ? "," : "");
+  }
+  printf("\n");
+  return 0;
+}
@@ -0,0 +1,63 @@
+/* ----------------------------------------------------------
+**
+**
+**   Seeded random numbers for the generators and fuzzers
+**
+**   xoshiro256** seeded through splitmix64: fast, and the same
+**   seed gives the same sequence with any compiler or platform,
+**   unlike the std:: distributions.
+**
+**   Luke Rule
+**
+---------------------------------------------------------- */
+#ifndef XOSHIRO_H
+#define XOSHIRO_H
+
+#include <stdint.h>
+
+struct xoshiro256 {
+  uint64_t s[4];
+
+  explicit xoshiro256(uint64_t seed) {
+    for (int i = 0; i < 4; i++) {
+      seed += 0x9e3779b97f4a7c15ULL;
+      uint64_t z = seed;
+      z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+      z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+      s[i] = z ^ (z >> 31);
+    }
+  }
+
+  uint64_t next() {
+    uint64_t result = rotl(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl(s[3], 45);
+    return result;
+  }
+
+  // 0 to n - 1
+  uint32_t below(uint32_t n) {
+    return uint32_t(((next() >> 32) * n) >> 32);
+  }
+
+  // low to high inclusive
+  int between(int low, int high) {
+    return low + int(below(uint32_t(high - low + 1)));
+  }
+
+  // [low, high)
+  double uniform(double low, double high) {
+    return low + (high - low) * ((next() >> 11) * (1.0 / 9007199254740992.0));
+  }
+
+  static uint64_t rotl(uint64_t v, int k) {
+    return (v << k) | (v >> (64 - k));
+  }
+};
+
+#endif
@@ -0,0 +1,260 @@
+/* ----------------------------------------------------------
+**
+**
+**   Zoom-path animation renderer
+**
+**   Luke Rule
+**
+---------------------------------------------------------- */
+#include "zoom_animation.h"
+
+#include <math.h>
+#include <map>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <condition_variable>
+#include <algorithm>
+
+// Step of a (possibly fractional) zoom level, exactly the hardware step at whole levels. With
+// steps_per_octave the zoom is held at the last multiple of 1 / steps_per_octave it reached, and
+// the step is the level-10 step of its fraction shifted up by whole levels, so equal fractions an
+// octave apart have steps exactly two apart.
+static int64_t zoom_step(double zoom, int steps_per_octave) {
+  zoom = std::min(std::max(zoom, 0.0), double(MAX_ZOOM));
+  if (steps_per_octave > 0) {
+    // the small bias keeps whole levels reached by adding up fractions from rounding down
+    int64_t quantum = int64_t(floor(zoom * steps_per_octave + 1e-9));
+    int level = int(quantum / steps_per_octave);
+    int fraction = int(quantum % steps_per_octave);
+    return std::max<int64_t>(1, llround(BASE_INCREMENT_AMOUNT * exp2(-double(fraction) / steps_per_octave))) << (MAX_ZOOM - level);
+  }
+  return std::max<int64_t>(1, llround(BASE_INCREMENT_AMOUNT * exp2(MAX_ZOOM - zoom)));
+}
+
+// centre in Q3.29, optionally rounded to a multiple of step, wrapped to 32 bits like the registers
+static fixed_32 centre_fixed(double value, int64_t step, bool snap) {
+  int64_t fixed = llround(value * (1 << FRAC_BITS));
+  if (snap) {
+    fixed = llround(double(fixed) / double(step)) * step;
+  }
+  return fixed_32(unsigned_fixed_32(fixed));
+}
+
+static coord_step frame_view(double center_x, double center_y, int64_t step, int width, int height, bool snap) {
+  coord_step c;
+  c.step = fixed_32(step);
+  c.x = step_coord(centre_fixed(center_x, step, snap), c.step, -(width >> 1));
+  c.y = step_coord(centre_fixed(center_y, step, snap), c.step, height >> 1);
+  return c;
+}
+
+std::vector<coord_step> plan_zoom_path(const std::vector<zoom_keyframe>& keyframes, int width, int height, bool snap, int steps_per_octave) {
+  std::vector<coord_step> frames;
+  if (!snap) {
+    steps_per_octave = 0;
+  }
+  for (size_t k = 0; k + 1 < keyframes.size(); k++) {
+    const zoom_keyframe& from = keyframes[k];
+    const zoom_keyframe& to = keyframes[k + 1];
+    double from_step = double(zoom_step(from.zoom, steps_per_octave));
+    for (int f = 0; f < from.frames; f++) {
+      double t = double(f) / from.frames;
+      int64_t step = zoom_step(from.zoom + (to.zoom - from.zoom) * t, steps_per_octave);
+      // the target's offset from the screen centre, in pixels, shrinks linearly to zero
+      double remaining = (1.0 - t) * double(step) / from_step;
+      frames.push_back(frame_view(to.center_x - (to.center_x - from.center_x) * remaining,
+                                  to.center_y - (to.center_y - from.center_y) * remaining, step, width, height, snap));
+    }
+  }
+  if (!keyframes.empty()) {
+    const zoom_keyframe& last = keyframes.back();
+    frames.push_back(frame_view(last.center_x, last.center_y, zoom_step(last.zoom, steps_per_octave), width, height, snap));
+  }
+  return frames;
+}
+
+struct reference_frame {
+  coord_step c;
+  std::vector<uint16_t> iterations;
+};
+
+// For each of count pixels along one axis, the index of the reference pixel with the same
+// coordinate, or -1. direction is +1 for x (left to right) and -1 for y (top to bottom).
+static void map_axis(fixed_32 start, fixed_32 step, int count, fixed_32 ref_start, fixed_32 ref_step, int ref_count, int direction, std::vector<int>& map) {
+  map.resize(count);
+  for (int i = 0; i < count; i++) {
+    unsigned_fixed_32 value = step_coord(start, step, direction * i);
+    unsigned_fixed_32 offset = direction > 0 ? value - unsigned_fixed_32(ref_start) : unsigned_fixed_32(ref_start) - value;
+    unsigned_fixed_32 index = offset / unsigned_fixed_32(ref_step);
+    map[i] = (offset % unsigned_fixed_32(ref_step) == 0 && index < unsigned_fixed_32(ref_count)) ? int(index) : -1;
+  }
+}
+
+// iterate one frame into out, copying every pixel that a reference already holds; returns pixels reused
+static size_t iterate_with_reuse(const coord_step& c, int max_iterations, int width, int height, const std::deque<reference_frame*>& references, uint16_t* out) {
+  size_t refs = references.size();
+  std::vector<std::vector<int>> x_maps(refs), y_maps(refs);
+  for (size_t r = 0; r < refs; r++) {
+    const coord_step& rc = references[r]->c;
+    map_axis(c.x, c.step, width, rc.x, rc.step, width, 1, x_maps[r]);
+    map_axis(c.y, c.step, height, rc.y, rc.step, height, -1, y_maps[r]);
+  }
+
+  size_t reused = 0;
+  std::vector<const int*> row_x_maps;
+  std::vector<const uint16_t*> row_sources;
+  for (int y = 0; y < height; y++) {
+    // references that share this row, most recent first
+    row_x_maps.clear();
+    row_sources.clear();
+    for (size_t r = 0; r < refs; r++) {
+      if (y_maps[r][y] >= 0) {
+        row_x_maps.push_back(x_maps[r].data());
+        row_sources.push_back(references[r]->iterations.data() + size_t(y_maps[r][y]) * width);
+      }
+    }
+    fixed_32 y_pos = step_coord(c.y, c.step, -y);
+    uint16_t* row = out + size_t(y) * width;
+    for (int x = 0; x < width; x++) {
+      int count = -1;
+      for (size_t r = 0; r < row_x_maps.size(); r++) {
+        if (row_x_maps[r][x] >= 0) {
+          count = row_sources[r][row_x_maps[r][x]];
+          break;
+        }
+      }
+      if (count < 0) {
+        count = iterate_point(step_coord(c.x, c.step, x), y_pos, max_iterations);
+      }
+      else {
+        reused++;
+      }
+      row[x] = count;
+    }
+  }
+  return reused;
+}
+
+animation_stats render_animation(const std::vector<coord_step>& frames, const animation_options& options, const animation_sink& sink) {
+  animation_stats stats;
+  int width = std::min(std::max(options.width, 1), MAX_XSIZE);
+  int height = std::min(std::max(options.height, 1), MAX_YSIZE);
+  int max_iterations = options.max_iterations;
+  if (max_iterations <= 0 || max_iterations > MAX_ITERATIONS) {
+    max_iterations = 1;
+  }
+  int threads = std::max(1, options.threads);
+  int chunk_frames = std::max(1, options.chunk_frames);
+  int max_buffered = options.max_buffered > 0 ? options.max_buffered : 2 * threads * chunk_frames;
+  int frame_count = int(frames.size());
+  int chunks = (frame_count + chunk_frames - 1) / chunk_frames;
+
+  std::vector<colour> unique_colours;
+  std::vector<colour> interp_points(options.colours, options.colours + 6);
+  std::vector<colour> colour_map;
+  generate_unique_colours(unique_colours, interp_points);
+  generate_colour_map(max_iterations, unique_colours, colour_map);
+
+  std::mutex mutex;
+  std::condition_variable changed;
+  int next_chunk = 0;
+  int next_write = 0;
+  int workers_running = threads;
+  bool stop = false;
+  std::map<int, std::vector<colour>> finished;
+  size_t reused_total = 0;
+
+  auto worker = [&]() {
+    std::deque<reference_frame*> references;
+    std::vector<reference_frame> storage(ANIMATION_REFERENCE_FRAMES + 1);
+    size_t reused = 0;
+    while (true) {
+      int chunk;
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        chunk = stop ? chunks : next_chunk++;
+      }
+      if (chunk >= chunks) {
+        break;
+      }
+      // frames of a new chunk are not contiguous with the last one, start without references
+      references.clear();
+      for (int f = chunk * chunk_frames; f < std::min(frame_count, (chunk + 1) * chunk_frames); f++) {
+        {
+          // the frame the writer waits for is never held back, so this cannot deadlock
+          std::unique_lock<std::mutex> lock(mutex);
+          changed.wait(lock, [&] { return stop || int(finished.size()) < max_buffered || f == next_write; });
+          if (stop) {
+            break;
+          }
+        }
+        reference_frame* current = nullptr;
+        for (reference_frame& candidate : storage) {
+          if (std::find(references.begin(), references.end(), &candidate) == references.end()) {
+            current = &candidate;
+            break;
+          }
+        }
+        current->c = frames[f];
+        current->iterations.resize(size_t(width) * height);
+        reused += iterate_with_reuse(frames[f], max_iterations, width, height, references, current->iterations.data());
+
+        std::vector<colour> framebuffer(size_t(width) * height);
+        colouriseMandelbrot(current->iterations.data(), width, framebuffer.data(), width, width, height, max_iterations, colour_map);
+
+        references.push_front(current);
+        if (references.size() > ANIMATION_REFERENCE_FRAMES) {
+          references.pop_back();
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        finished[f] = std::move(framebuffer);
+        changed.notify_all();
+      }
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    reused_total += reused;
+    workers_running--;
+    changed.notify_all();
+  };
+
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> workers;
+  for (int t = 0; t < threads; t++) {
+    workers.emplace_back(worker);
+  }
+
+  // hand frames to the sink in order on this thread, the encoder sees one sequential stream
+  for (int f = 0; f < frame_count; f++) {
+    std::vector<colour> framebuffer;
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      changed.wait(lock, [&] { return finished.count(f) != 0 || workers_running == 0; });
+      auto it = finished.find(f);
+      if (it == finished.end()) {
+        break;
+      }
+      framebuffer = std::move(it->second);
+      finished.erase(it);
+      next_write = f + 1;
+      changed.notify_all();
+    }
+    stats.frames++;
+    if (sink && !sink(f, framebuffer.data(), width, height)) {
+      std::lock_guard<std::mutex> lock(mutex);
+      stop = true;
+      changed.notify_all();
+      break;
+    }
+  }
+  for (std::thread& w : workers) {
+    w.join();
+  }
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+  stats.seconds = elapsed.count();
+  stats.pixels = stats.frames * size_t(width) * height;
+  stats.reused_pixels = reused_total;
+  return stats;
+}
@@ -0,0 +1,66 @@
+/* ----------------------------------------------------------
+**
+**
+**   Zoom-path animation renderer
+**
+**   Renders a frame sequence along a keyframe path of centres
+**   and zoom levels, reusing iteration counts wherever a pixel
+**   lands exactly on a grid point of a recently rendered frame
+**
+**   Luke Rule
+**
+---------------------------------------------------------- */
+#ifndef ZOOM_ANIMATION_H
+#define ZOOM_ANIMATION_H
+
+#include <stddef.h>
+#include <functional>
+#include <vector>
+
+#include "mandelbrot_renderer.h"
+
+// earlier frames of the same chunk searched for reusable samples
+#define ANIMATION_REFERENCE_FRAMES 4
+
+struct zoom_keyframe {
+  double center_x;
+  double center_y;
+  double zoom;      // as the zoom register, fractional values give steps between hardware levels
+  int frames;       // frames spent travelling to the next keyframe
+};
+
+struct animation_options {
+  int width = DEFAULT_XSIZE;
+  int height = DEFAULT_YSIZE;
+  int max_iterations = 180;
+  colour colours[6] = {0x001f, 0x07ff, 0x07e0, 0xffe0, 0xf800, 0xf81f};
+  int threads = 1;
+  // consecutive frames rendered by one worker, reuse only looks back within a chunk
+  int chunk_frames = 8;
+  // finished frames waiting to be written before workers pause, 0 picks 2 * threads * chunk_frames
+  int max_buffered = 0;
+};
+
+struct animation_stats {
+  size_t frames = 0;
+  size_t pixels = 0;
+  size_t reused_pixels = 0;
+  double seconds = 0.0;
+};
+
+// receives finished frames in order; return false to stop the render
+using animation_sink = std::function<bool(int index, const colour* framebuffer, int width, int height)>;
+
+// Turn keyframes into per-frame views. Zoom moves linearly (the step geometrically) and the
+// centre moves so the next keyframe's centre glides to the middle of the screen. With snap,
+// each centre is rounded to a multiple of its step, which puts frames with equal steps on
+// one lattice: a pan then shares every pixel except the newly exposed strip, and a zoom by
+// exactly two shares a quarter of the pixels. A continuous zoom changes the step every frame
+// and shares almost nothing, so snap also holds the step for steps_per_octave steps per
+// octave, exact powers of two apart (0 keeps it continuous).
+std::vector<coord_step> plan_zoom_path(const std::vector<zoom_keyframe>& keyframes, int width, int height, bool snap = true, int steps_per_octave = ANIMATION_REFERENCE_FRAMES);
+
+// Render frames on options.threads workers, chunk by chunk, and hand them to sink in order.
+animation_stats render_animation(const std::vector<coord_step>& frames, const animation_options& options, const animation_sink& sink);
+
+#endif